@@ -0,0 +1,91 @@
+#include "state_machine.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace {
+namespace sm = state_machine;
+
+// Steps many payload-free protocol trackers with the same event on every tick, comparing a
+// `LookupStateMachine` per tracker with stepping an array of state indices with `LookupBatch`.
+// The batch uses vector instructions when compiled for a target with SSSE3 or AVX2.
+
+// states
+struct Idle {};
+struct Connecting {};
+struct Connected {};
+struct Closing {};
+
+// events
+struct tick {};
+struct reset {};
+
+template <class State>
+struct to {
+    constexpr to() = default;
+    constexpr auto operator()() const noexcept -> State { return {}; }
+};
+
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+constexpr auto transition_table =
+    // clang-format off
+    sm::make_transition_table(
+        state<Idle>,       event<tick>,  _, to<Connecting>{}, state<Connecting>,
+        state<Connecting>, event<tick>,  _, to<Connected>{},  state<Connected>,
+        state<Connected>,  event<tick>,  _, to<Closing>{},    state<Closing>,
+        state<Closing>,    event<tick>,  _, to<Idle>{},       state<Idle>,
+        state<Connected>,  event<reset>, _, to<Idle>{},       state<Idle>
+    );
+// clang-format on
+
+using Table = sm::static_table<decltype(transition_table), transition_table>;
+
+constexpr size_t num_machines = size_t{1} << 20U;
+constexpr size_t num_ticks = 100;
+
+template <class F>
+auto time_ns_per_step(F&& f) -> double {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < num_ticks; ++t) {
+        f();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    return ns / static_cast<double>(num_machines * num_ticks);
+}
+
+} // namespace
+
+auto main() -> int {
+    std::vector<sm::LookupStateMachine<Table>> machines(num_machines);
+    const auto scalar = time_ns_per_step([&machines] {
+        for (auto& m : machines) {
+            m.process_event(tick{});
+        }
+    });
+
+    const sm::LookupBatch<Table> batch{};
+    std::vector<uint8_t> states(num_machines);
+    batch.start(states.data(), states.size());
+    const auto vectorized = time_ns_per_step(
+        [&batch, &states] { batch.process_event(states.data(), states.size(), tick{}); });
+
+    // Both representations must agree on the final state.
+    if (machines.front().state_index() != states.front()) {
+        std::cerr << "state mismatch" << std::endl;
+        return 1;
+    }
+
+    std::cout << "machines: " << num_machines << ", ticks: " << num_ticks << '\n';
+    std::cout << "LookupStateMachine::process_event: " << scalar << " ns/step\n";
+    std::cout << "LookupBatch::process_event:        " << vectorized << " ns/step\n";
+
+    return 0;
+}
@@ -105,12 +105,15 @@ constexpr auto transition_table =
 // clang-format on
 
 using Table = decltype(transition_table);
-using StateMachine = sm::StateMachine<const Table&>;
+// The table is named in the type of the machine rather than stored in each machine.
+using StateMachine = sm::StateMachine<sm::static_table<Table, transition_table>>;
+
+static_assert(sizeof(StateMachine) == sizeof(StateMachine::variant_type), "");
 
 } // namespace player
 
 struct Player : player::StateMachine {
-    Player() : player::StateMachine{player::transition_table} {}
+    Player() = default;
 };
 
 } // namespace
@@ -1,13 +1,44 @@
 #pragma once
 
+#include "state_machine/bulk_ingest.h"
+#include "state_machine/event_queue.h"
+#include "state_machine/lookup_batch.h"
+#include "state_machine/lookup_state_machine.h"
+#include "state_machine/machine_pool.h"
+#include "state_machine/mailbox.h"
+#include "state_machine/session_map.h"
+#include "state_machine/sharded_executor.h"
 #include "state_machine/state_machine.h"
 #include "state_machine/transition/transition.h"
 
 namespace state_machine {
 
+using ::state_machine::state_machine::boxed_policy;
+using ::state_machine::state_machine::BulkIngest;
+using ::state_machine::state_machine::default_policy;
+using ::state_machine::state_machine::double_buffer_policy;
+using ::state_machine::state_machine::EventQueue;
+using ::state_machine::state_machine::is_payload_free;
+using ::state_machine::state_machine::LookupBatch;
+using ::state_machine::state_machine::LookupStateMachine;
+using ::state_machine::state_machine::Mailbox;
+using ::state_machine::state_machine::MachinePool;
+using ::state_machine::state_machine::make_lookup_state_machine;
 using ::state_machine::state_machine::make_state_machine;
+using ::state_machine::state_machine::overflow_policy;
+using ::state_machine::state_machine::packed_policy;
+using ::state_machine::state_machine::pmr_policy;
+using ::state_machine::state_machine::post_status;
 using ::state_machine::state_machine::process_status;
+using ::state_machine::state_machine::recycling_policy;
+using ::state_machine::state_machine::SessionMap;
+using ::state_machine::state_machine::ShardedExecutor;
 using ::state_machine::state_machine::StateMachine;
+using ::state_machine::state_machine::static_table;
+using ::state_machine::state_machine::status_policy;
+using ::state_machine::transition::emplace;
+using ::state_machine::transition::reuse;
+using ::state_machine::variant::visit;
 
 namespace placeholder {
 constexpr auto _ = transition::empty_placeholder;
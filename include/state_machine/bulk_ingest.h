@@ -0,0 +1,212 @@
+#pragma once
+
+#include "state_machine/error.h"
+#include "state_machine/state_machine.h"
+#include "state_machine/variant.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace state_machine {
+namespace state_machine {
+
+namespace detail {
+
+// Hint that `address` will be read soon.
+inline auto prefetch(const void* address) noexcept -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    static_cast<void>(address);
+#endif
+}
+
+// Process `event` with `machine`. A Variant over events is visited, so one batch may mix event
+// types.
+template <class Machine,
+          class Event,
+          std::enable_if_t<!variant::is_variant<std::remove_const_t<Event>>::value, int> = 0>
+auto deliver_event(Machine& machine, Event& event) -> process_status {
+    return machine.process_event(event);
+}
+
+template <class Machine,
+          class Event,
+          std::enable_if_t<variant::is_variant<std::remove_const_t<Event>>::value, int> = 0>
+auto deliver_event(Machine& machine, Event& event) -> process_status {
+    return event.visit([&machine](auto& e) { return machine.process_event(e); });
+}
+
+} // namespace detail
+
+// Processes batches of events addressed to many state machines, grouping the events by machine.
+//
+// A batch is given as parallel arrays of keys and events, where `keys[i]` is the index of the
+// machine in a random access collection, such as a `std::vector<StateMachine<Table>>`, that
+// receives `events[i]`. The events of a batch may be of one type, or Variants over the event types
+// of the Table, or event indices with pointers to their payloads as for `process_event_id`.
+// Processing events in arrival order touches a different machine for almost
+// every event. `process_events` instead sorts the positions of the events by key with a stable
+// radix sort, so the events of each machine keep their order, and then processes the events of
+// each machine back to back while the storage of the next machine is prefetched. The result of each
+// `process_event` is written to the position of its event in a parallel array of `process_status`.
+//
+// A BulkIngest keeps its sort buffers between batches, so it allocates only while batches grow.
+template <class Key = uint32_t>
+class BulkIngest {
+    static_assert(std::is_integral<Key>::value && std::is_unsigned<Key>::value,
+                  "The keys of a `BulkIngest` must be unsigned machine indices.");
+
+  public:
+    using key_type = Key;
+
+    // Process `events[i]` for `machines[keys[i]]` and store the result in `statuses[i]`, for each
+    // `i < count`. Events for keys outside of `machines` are not processed and are reported as an
+    // `InvalidState`. Each event is passed as an lvalue, so the events of a non-const array may be
+    // modified by actions taking `Event&`. If `Event` is a Variant, each event must hold a value.
+    template <class Machines, class Event>
+    auto process_events(Machines& machines,
+                        const Key* keys,
+                        Event* events,
+                        size_t count,
+                        process_status* statuses) -> void {
+        process_by_key(machines, keys, count, statuses, [events](auto& machine, size_t i) {
+            return detail::deliver_event(machine, events[i]);
+        });
+    }
+
+    // Process the event of index `event_ids[i]`, with its bytes at `payloads[i]`, for
+    // `machines[keys[i]]` and store the result in `statuses[i]`, for each `i < count`, as with
+    // `StateMachine::process_event_id`. Keys outside of `machines` are handled as above.
+    template <class Machines, class EventId>
+    auto process_event_ids(Machines& machines,
+                           const Key* keys,
+                           const EventId* event_ids,
+                           const void* const* payloads,
+                           size_t count,
+                           process_status* statuses) -> void {
+        static_assert(std::is_integral<EventId>::value,
+                      "The event indices of a batch must be integers.");
+
+        process_by_key(
+            machines, keys, count, statuses, [event_ids, payloads](auto& machine, size_t i) {
+                return machine.process_event_id(static_cast<size_t>(event_ids[i]), payloads[i]);
+            });
+    }
+
+  private:
+    using position_type = uint32_t;
+
+    static constexpr unsigned digit_bits = 11;
+    static constexpr size_t num_buckets = size_t{1} << digit_bits;
+
+    // Call `process(machines[keys[i]], i)` for each `i < count` with a key below the size of
+    // `machines`, grouped by key and in order for each key, and store the result in `statuses[i]`.
+    template <class Machines, class F>
+    auto process_by_key(Machines& machines,
+                        const Key* keys,
+                        size_t count,
+                        process_status* statuses,
+                        F&& process) -> void {
+        const size_t num_machines = machines.size();
+        partition(keys, count, num_machines, statuses);
+
+        const auto* order = order_.data();
+        const auto size = order_.size();
+
+        size_t i = 0;
+        while (i < size) {
+            const auto key = keys[order[i]];
+
+            auto end = i + 1;
+            while ((end < size) && (keys[order[end]] == key)) {
+                ++end;
+            }
+            if (end < size) {
+                detail::prefetch(&machines[keys[order[end]]]);
+            }
+
+            auto& machine = machines[key];
+            for (; i < end; ++i) {
+                statuses[order[i]] = process(machine, order[i]);
+            }
+        }
+    }
+
+    // Fill `order_` with the positions of the events for keys below `num_machines`, stably sorted
+    // by key, and report the other events as an `InvalidState`.
+    auto partition(const Key* keys, size_t count, size_t num_machines, process_status* statuses)
+        -> void {
+        if (count > std::numeric_limits<position_type>::max()) {
+            error::raise(std::length_error{"BulkIngest batch too large"});
+        }
+
+        order_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            const size_t key = keys[i];
+            if (key < num_machines) {
+                order_.push_back(static_cast<position_type>(i));
+            } else {
+                statuses[i] = process_status::InvalidState;
+            }
+        }
+
+        if (order_.empty()) {
+            return;
+        }
+
+        // Sort by the digits of the largest key, least significant first.
+        unsigned key_bits = 0;
+        while ((key_bits < std::numeric_limits<size_t>::digits) &&
+               (((num_machines - 1) >> key_bits) != 0)) {
+            ++key_bits;
+        }
+
+        scratch_.resize(order_.size());
+        for (unsigned shift = 0; shift < key_bits; shift += digit_bits) {
+            sort_by_digit(keys, shift);
+        }
+    }
+
+    auto sort_by_digit(const Key* keys, unsigned shift) -> void {
+        const auto digit = [keys, shift](position_type p) noexcept -> size_t {
+            const size_t key = keys[p];
+            return (key >> shift) & (num_buckets - 1);
+        };
+
+        counts_.fill(0);
+        for (auto p : order_) {
+            ++counts_[digit(p)];
+        }
+
+        size_t offset = 0;
+        for (auto& c : counts_) {
+            const auto n = c;
+            c = offset;
+            offset += n;
+        }
+
+        for (auto p : order_) {
+            scratch_[counts_[digit(p)]++] = p;
+        }
+        order_.swap(scratch_);
+    }
+
+    std::vector<position_type> order_;
+    std::vector<position_type> scratch_;
+    std::array<size_t, num_buckets> counts_{};
+};
+
+template <class Key>
+constexpr unsigned BulkIngest<Key>::digit_bits;
+
+template <class Key>
+constexpr size_t BulkIngest<Key>::num_buckets;
+
+} // namespace state_machine
+} // namespace state_machine
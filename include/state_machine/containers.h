@@ -25,6 +25,7 @@ using ::state_machine::containers::operations::make_unique;
 using ::state_machine::containers::operations::map;
 using ::state_machine::containers::operations::pop_front;
 using ::state_machine::containers::operations::repack;
+using ::state_machine::containers::operations::size;
 
 } // namespace op
 } // namespace containers
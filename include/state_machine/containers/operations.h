@@ -2,6 +2,7 @@
 
 #include "state_machine/containers/basic.h"
 
+#include <cstddef>
 #include <type_traits>
 
 namespace state_machine {
@@ -12,14 +13,13 @@ namespace operations {
 namespace detail {
 using ::state_machine::containers::basic::inheritor;
 
-template <class K, class... Ts>
+template <class K, class L>
 struct contains_impl;
 
+// Only the outermost template is unpacked. A single element that is itself a template
+// specialization must not be unpacked again.
 template <class K, template <class...> class L, class... Ts>
-struct contains_impl<K, L<Ts...>> : contains_impl<K, Ts...> {};
-
-template <class K, class... Ts>
-struct contains_impl {
+struct contains_impl<K, L<Ts...>> {
     using type = std::is_base_of<K, inheritor<Ts...>>;
 };
 
@@ -172,6 +172,21 @@ struct pop_front_impl<L<T, Ts...>> : L<Ts...> {};
 template <class L>
 using pop_front = typename detail::pop_front_impl<L>::type;
 
+
+namespace detail {
+
+template <class L>
+struct size_impl;
+
+template <template <class...> class L, class... Ts>
+struct size_impl<L<Ts...>> : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+} // namespace detail
+
+// Given L<Ts...> return the number of elements in Ts... as a std::integral_constant.
+template <class L>
+using size = typename detail::size_impl<L>::type;
+
 } // namespace operations
 } // namespace containers
 } // namespace state_machine
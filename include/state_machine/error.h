@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+
+// Errors are thrown as exceptions unless exceptions are disabled, either by compiling with
+// `-fno-exceptions` or by defining `STATE_MACHINE_NO_EXCEPTIONS`. Errors are then passed to the
+// handler set with `error::set_handler` and the program is aborted.
+#if !defined(STATE_MACHINE_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && \
+    !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define STATE_MACHINE_NO_EXCEPTIONS
+#endif
+
+namespace state_machine {
+namespace error {
+
+// Called with an error that would otherwise be thrown. A handler should not return, for example
+// by logging the error and terminating the program. `std::abort` is called if it does.
+using handler = void (*)(const std::exception&);
+
+namespace detail {
+
+inline auto current_handler() noexcept -> std::atomic<handler>& {
+    static std::atomic<handler> current{nullptr};
+    return current;
+}
+
+} // namespace detail
+
+// Set the handler called for errors if exceptions are disabled, returning the previous handler.
+inline auto set_handler(handler h) noexcept -> handler {
+    return detail::current_handler().exchange(h);
+}
+
+inline auto get_handler() noexcept -> handler { return detail::current_handler().load(); }
+
+// Throw `e`, or pass it to the error handler if exceptions are disabled.
+template <class Error>
+[[noreturn]] auto raise(const Error& e) -> void {
+#ifdef STATE_MACHINE_NO_EXCEPTIONS
+    if (auto* h = get_handler()) {
+        h(e);
+    }
+    std::abort();
+#else
+    throw e;
+#endif
+}
+
+} // namespace error
+} // namespace state_machine
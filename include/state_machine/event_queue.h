@@ -0,0 +1,104 @@
+#pragma once
+
+#include "state_machine/containers.h"
+#include "state_machine/spsc_queue.h"
+#include "state_machine/state_machine.h"
+#include "state_machine/variant.h"
+
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace state_machine {
+namespace state_machine {
+
+// A bounded lock-free queue of events for the state machines of one Table, written by one producer
+// thread and drained by one consumer thread.
+//
+// Each slot holds a `Variant` over the `event_types` of the Table, so the size of a slot is known
+// at compile time and an event is moved into its slot by `try_push` and out of it by `drain`
+// without allocating. The slots are allocated once, when the queue is created. The producer and
+// consumer indices are kept on separate cache lines.
+//
+// `drain(machine, budget)` processes up to `budget` queued events in order, each to completion
+// before the next, taking them from the queue in batches of at most `batch_size`. A machine must
+// only be drained by one thread at a time.
+template <class Table>
+class EventQueue {
+  public:
+    using table_type = typename detail::table_of<Table>::type;
+    using event_types = typename table_type::event_types;
+
+    // The type holding a queued event of any of the `event_types`.
+    using event_type = op::repack<event_types, variant::Variant>;
+
+    static constexpr size_t default_capacity = 1024;
+
+    // The largest number of events taken from the queue at once.
+    static constexpr size_t batch_size = 64;
+
+    // Create a queue holding at least `capacity` events. The capacity is rounded up to a power of
+    // two.
+    explicit EventQueue(size_t capacity = default_capacity) : ring_{capacity} {}
+
+    // Append `event`, if the queue is not full. Called by the producer.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto try_push(Event&& event) -> bool {
+        return ring_.try_emplace(std::forward<Event>(event));
+    }
+
+    // Process up to `budget` queued events with `machine`, in the order they were pushed. Returns
+    // the number of events processed. Called by the consumer.
+    template <class Machine>
+    auto drain(Machine& machine, size_t budget = std::numeric_limits<size_t>::max()) -> size_t {
+        return drain(machine, budget, [](process_status) {});
+    }
+
+    // Process up to `budget` queued events with `machine` as above, calling `on_processed` with the
+    // result of each `process_event`.
+    template <class Machine, class F>
+    auto drain(Machine& machine, size_t budget, F&& on_processed) -> size_t {
+        size_t processed = 0;
+        while (processed < budget) {
+            const auto remaining = budget - processed;
+            const auto count = ring_.consume(
+                (remaining < batch_size) ? remaining : batch_size, [&](slot& s) {
+                    on_processed(s.event.visit(
+                        [&machine](auto& e) { return machine.process_event(std::move(e)); }));
+                });
+            if (count == 0) {
+                break;
+            }
+            processed += count;
+        }
+        return processed;
+    }
+
+    auto capacity() const noexcept -> size_t { return ring_.capacity(); }
+
+    // Check if the queue is empty. Exact only when called by the consumer with no producer running.
+    auto empty() const noexcept -> bool { return ring_.empty(); }
+
+  private:
+    struct slot {
+        template <class Event>
+        explicit slot(Event&& e) {
+            event.template emplace<std::decay_t<Event>>(std::forward<Event>(e));
+        }
+
+        event_type event;
+    };
+
+    detail::spsc_ring<slot> ring_;
+};
+
+template <class Table>
+constexpr size_t EventQueue<Table>::default_capacity;
+
+template <class Table>
+constexpr size_t EventQueue<Table>::batch_size;
+
+} // namespace state_machine
+} // namespace state_machine
@@ -0,0 +1,365 @@
+#pragma once
+
+#include "state_machine/backport.h"
+#include "state_machine/containers.h"
+#include "state_machine/lookup_state_machine.h"
+#include "state_machine/state_machine.h"
+#include "state_machine/traits.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace state_machine {
+namespace state_machine {
+
+namespace detail {
+
+// Replace each of the first `count` indices with `table[index]`, where `table` has 16 entries,
+// with byte shuffles. Returns the number of indices replaced, a multiple of the vector width,
+// leaving the remainder to the caller. Returns 0 if the target has no byte shuffle.
+inline auto shuffle_lookup(uint8_t* indices, size_t count, const uint8_t* table) noexcept
+    -> size_t {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const auto table256 =
+        _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+    for (; i + 32 <= count; i += 32) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        auto* p = reinterpret_cast<__m256i*>(indices + i);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(table256, _mm256_loadu_si256(p)));
+    }
+#endif
+#if defined(__SSSE3__)
+    const auto table128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+    for (; i + 16 <= count; i += 16) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        auto* p = reinterpret_cast<__m128i*>(indices + i);
+        _mm_storeu_si128(p, _mm_shuffle_epi8(table128, _mm_loadu_si128(p)));
+    }
+#else
+    static_cast<void>(indices);
+    static_cast<void>(count);
+    static_cast<void>(table);
+#endif
+    return i;
+}
+
+// Replace each of the first `count` indices `s` with `table[s * (num_events + 1) + e]`, where `e`
+// is `events[i]` clamped to `num_events`, or with `table[s]` if `events` is null, with 32-bit
+// gathers. Column `num_events` of the table holds the states unchanged, for event indices out of
+// range. Returns the number of indices replaced, as `shuffle_lookup` does. Returns 0 if the target
+// has no gather.
+inline auto gather_lookup(uint8_t* indices,
+                          const uint8_t* events,
+                          size_t count,
+                          size_t num_events,
+                          const int32_t* table) noexcept -> size_t {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const auto last_event = _mm256_set1_epi32(static_cast<int>(num_events));
+    const auto stride = _mm256_set1_epi32(static_cast<int>(num_events + 1));
+    const auto low_bytes = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+    for (; i + 8 <= count; i += 8) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        auto* p = reinterpret_cast<__m128i*>(indices + i);
+        auto k = _mm256_cvtepu8_epi32(_mm_loadl_epi64(p));
+        if (events != nullptr) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            const auto* e = reinterpret_cast<const __m128i*>(events + i);
+            const auto event =
+                _mm256_min_epu32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(e)), last_event);
+            k = _mm256_add_epi32(_mm256_mullo_epi32(k, stride), event);
+        }
+
+        // Narrow the eight 32-bit results to bytes, which land in the low 4 bytes of each lane.
+        auto next = _mm256_i32gather_epi32(table, k, 4);
+        next = _mm256_packus_epi16(_mm256_packus_epi32(next, next), next);
+        next = _mm256_permutevar8x32_epi32(next, low_bytes);
+        _mm_storel_epi64(p, _mm256_castsi256_si128(next));
+    }
+#else
+    static_cast<void>(indices);
+    static_cast<void>(events);
+    static_cast<void>(count);
+    static_cast<void>(num_events);
+    static_cast<void>(table);
+#endif
+    return i;
+}
+
+// Check if every machine can process the event with index `Event` by a table lookup: no guard or
+// action must be called, and no entry or exit action fires.
+template <class Lookup>
+constexpr auto is_lookup_only_event(size_t event) noexcept -> bool {
+    for (size_t s = 0; s < Lookup::num_states; ++s) {
+        const auto& cell = Lookup::cells[(s * Lookup::num_events) + event];
+        if (cell.dynamic) {
+            return false;
+        }
+        if (cell.external &&
+            (Lookup::hooks::has_exit(s) || Lookup::hooks::has_entry(cell.next))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Lookup>
+constexpr auto is_lookup_only_table() noexcept -> bool {
+    for (size_t e = 0; e < Lookup::num_events; ++e) {
+        if (!is_lookup_only_event<Lookup>(e)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The state after processing `event` in `state`, `state` for an event index out of range, or 0 for
+// padding past the last state.
+template <class Lookup, class T>
+constexpr auto lookup_next(size_t state, size_t event) noexcept -> T {
+    if (state >= Lookup::num_states) {
+        return 0;
+    }
+    if (event >= Lookup::num_events) {
+        return static_cast<T>(state);
+    }
+
+    const auto& cell = Lookup::cells[(state * Lookup::num_events) + event];
+    return static_cast<T>(cell.external ? cell.next : state);
+}
+
+// The next state for each state given the event with index `event`.
+template <class Lookup, class T, size_t... Ks>
+constexpr auto make_event_next(size_t event, std::index_sequence<Ks...>) noexcept
+    -> std::array<T, sizeof...(Ks)> {
+    return {{lookup_next<Lookup, T>(Ks, event)...}};
+}
+
+// The next state for each element of the flattened [state][event] matrix, with an extra last
+// column leaving each state unchanged.
+template <class Lookup, class T, size_t... Ks>
+constexpr auto make_table_next(std::index_sequence<Ks...>) noexcept
+    -> std::array<T, sizeof...(Ks)> {
+    constexpr auto columns = Lookup::num_events + 1;
+    return {{lookup_next<Lookup, T>(Ks / columns, Ks % columns)...}};
+}
+
+} // namespace detail
+
+// Processes events for arrays of machines of a payload-free Table, each represented by the index
+// of its current state, as held by a `LookupStateMachine`.
+//
+// An event is processed for a whole array with table lookups if, for every state, the event
+// calls no guard or action and fires no entry or exit action (see `is_lookup_only`). With AVX2 or
+// SSSE3 enabled at compile time, tables of up to 16 states are stepped with byte shuffles, 32 or
+// 16 machines at a time, and larger tables with 32-bit gathers under AVX2. Other events are
+// processed one machine at a time, as `LookupStateMachine::process_event` does.
+template <class Table>
+class LookupBatch : private detail::lookup_table<Table> {
+    using lookup_base = detail::lookup_table<Table>;
+
+  public:
+    using typename lookup_base::event_types;
+    using typename lookup_base::initial_state_type;
+    using typename lookup_base::state_index_type;
+    using typename lookup_base::state_types;
+    using typename lookup_base::table_type;
+
+    // Check if `Event` is processed for every machine by a table lookup.
+    template <class Event>
+    using is_lookup_only = stdx::bool_constant<detail::is_lookup_only_event<lookup_base>(
+        lookup_base::template event_index<Event>())>;
+
+    explicit LookupBatch(Table&& table) : lookup_base{std::forward<Table>(table)} {}
+
+    // Create a LookupBatch for a `static_table`.
+    template <class T = Table, std::enable_if_t<detail::is_static_table<T>::value, int> = 0>
+    LookupBatch() {}
+
+    // Set each of `count` machines to the initial state, calling its entry action.
+    auto start(state_index_type* states, size_t count) const -> void {
+        for (size_t i = 0; i < count; ++i) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            states[i] = lookup_base::initial_index();
+            lookup_base::hooks::on_entry(lookup_base::initial_index());
+        }
+    }
+
+    // Process `event` for each of the `count` machines with current state indices `states`.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto process_event(state_index_type* states, size_t count, const Event& event) const -> void {
+        process_event_impl(states, count, event, is_lookup_only<Event>{});
+    }
+
+    // Process the event with index `events[i]` in `event_types` for the machine with current state
+    // index `states[i]`, for each of `count` machines. Events are default constructed, so every
+    // event type must be payload-free. Indices outside `event_types` leave the machine unchanged.
+    auto process_event_ids(state_index_type* states, const uint8_t* events, size_t count) const
+        -> void {
+        static_assert(op::repack<event_types, detail::all_payload_free>::value,
+                      "`process_event_ids` requires payload-free event types.");
+        static_assert(lookup_base::num_events <= std::numeric_limits<uint8_t>::max(),
+                      "`process_event_ids` requires at most 255 event types.");
+
+        process_event_ids_impl(
+            states,
+            events,
+            count,
+            stdx::bool_constant<detail::is_lookup_only_table<lookup_base>()>{});
+    }
+
+  private:
+    template <class Event>
+    auto process_event_impl(state_index_type* states,
+                            size_t count,
+                            const Event& event,
+                            std::false_type /* lookup only */) const -> void {
+        for (size_t i = 0; i < count; ++i) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            this->process(states[i], event);
+        }
+    }
+
+    template <class Event>
+    auto process_event_impl(state_index_type* states,
+                            size_t count,
+                            const Event&,
+                            std::true_type /* lookup only */) const -> void {
+        constexpr auto event = lookup_base::template event_index<Event>();
+
+        const auto& next = event_next<state_index_type, event>();
+        for (auto i = vector_lookup<event>(states, count); i < count; ++i) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            states[i] = next[states[i]];
+        }
+    }
+
+    // Step as many machines as the target allows with vector instructions.
+    template <size_t Event,
+              class T = state_index_type,
+              std::enable_if_t<std::is_same<T, uint8_t>::value, int> = 0>
+    static auto vector_lookup(T* states, size_t count) noexcept -> size_t {
+        if (lookup_base::num_states <= 16) {
+            return detail::shuffle_lookup(states, count, event_next<uint8_t, Event>().data());
+        }
+        return detail::gather_lookup(
+            states, nullptr, count, 1, event_next<int32_t, Event>().data());
+    }
+
+    template <size_t Event,
+              class T = state_index_type,
+              std::enable_if_t<!std::is_same<T, uint8_t>::value, int> = 0>
+    static auto vector_lookup(T*, size_t) noexcept -> size_t {
+        return 0;
+    }
+
+    // Padded to the 16 entries of a byte shuffle.
+    static constexpr size_t padded_states =
+        (lookup_base::num_states < 16) ? 16 : lookup_base::num_states;
+
+    template <class T, size_t Event>
+    static auto event_next() noexcept -> const std::array<T, padded_states>& {
+        static constexpr auto next = detail::make_event_next<lookup_base, T>(
+            Event, std::make_index_sequence<padded_states>{});
+        return next;
+    }
+
+    // The [state][event] matrix with a column for event indices out of range.
+    static constexpr size_t num_columns = lookup_base::num_events + 1;
+    static constexpr size_t num_cells = lookup_base::num_states * num_columns;
+
+    template <class T>
+    static auto table_next() noexcept -> const std::array<T, num_cells>& {
+        static constexpr auto next =
+            detail::make_table_next<lookup_base, T>(std::make_index_sequence<num_cells>{});
+        return next;
+    }
+
+    auto process_event_ids_impl(state_index_type* states,
+                                const uint8_t* events,
+                                size_t count,
+                                std::false_type /* lookup only */) const -> void {
+        for (size_t i = 0; i < count; ++i) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            process_default_event(states[i], events[i]);
+        }
+    }
+
+    auto process_event_ids_impl(state_index_type* states,
+                                const uint8_t* events,
+                                size_t count,
+                                std::true_type /* lookup only */) const -> void {
+        const auto i = vector_lookup_ids(states, events, count);
+
+        const auto& next = table_next<state_index_type>();
+        for (auto j = i; j < count; ++j) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            const size_t event = events[j];
+            const auto column = (event < lookup_base::num_events) ? event : lookup_base::num_events;
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            states[j] = next[(states[j] * num_columns) + column];
+        }
+    }
+
+    template <class T = state_index_type,
+              std::enable_if_t<std::is_same<T, uint8_t>::value, int> = 0>
+    static auto vector_lookup_ids(T* states, const uint8_t* events, size_t count) noexcept
+        -> size_t {
+        return detail::gather_lookup(
+            states, events, count, lookup_base::num_events, table_next<int32_t>().data());
+    }
+
+    template <class T = state_index_type,
+              std::enable_if_t<!std::is_same<T, uint8_t>::value, int> = 0>
+    static auto vector_lookup_ids(T*, const uint8_t*, size_t) noexcept -> size_t {
+        return 0;
+    }
+
+    auto process_default_event(state_index_type& index, size_t event) const -> void {
+        process_default_event_impl(
+            index, event, std::make_index_sequence<lookup_base::num_events>{});
+    }
+
+    using default_event_handler_type = void (*)(const LookupBatch&, state_index_type&);
+
+    template <size_t... Is>
+    auto process_default_event_impl(state_index_type& index,
+                                    size_t event,
+                                    std::index_sequence<Is...>) const -> void {
+        static constexpr default_event_handler_type handlers[] = {
+            &LookupBatch::handle_default_event<Is>...};
+
+        if (event < sizeof...(Is)) {
+            handlers[event](*this, index);
+        }
+    }
+
+    template <size_t I>
+    static auto handle_default_event(const LookupBatch& self, state_index_type& index) -> void {
+        using event_type =
+            typename table_type::event_index_map::template at_value<aux::index_constant<I>>;
+
+        self.process(index, event_type{});
+    }
+};
+
+template <class Table>
+constexpr size_t LookupBatch<Table>::padded_states;
+
+template <class Table>
+constexpr size_t LookupBatch<Table>::num_columns;
+
+template <class Table>
+constexpr size_t LookupBatch<Table>::num_cells;
+
+} // namespace state_machine
+} // namespace state_machine
@@ -0,0 +1,610 @@
+#pragma once
+
+#include "state_machine/backport.h"
+#include "state_machine/containers.h"
+#include "state_machine/state_machine.h"
+#include "state_machine/traits.h"
+#include "state_machine/transition/transition.h"
+#include "state_machine/transition/transition_table.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace state_machine {
+namespace state_machine {
+
+namespace detail {
+
+// A state without data. Such a state is represented by its index alone, and an object is created
+// on demand when a guard, action, or entry or exit action needs one.
+template <class State>
+using is_payload_free_state = stdx::conjunction<std::is_empty<State>,
+                                                std::is_trivially_default_constructible<State>,
+                                                std::is_trivially_destructible<State>>;
+
+template <class... States>
+struct all_payload_free : stdx::conjunction<is_payload_free_state<States>...> {};
+
+// Check if `F` is a stateless callable taking no arguments whose call is a constant expression.
+// Such a call has no effects, so a guard of this kind can be evaluated at compile time and an
+// action of this kind need not be called for a payload-free destination.
+template <class F, class = void>
+struct is_constant_invocable : std::false_type {};
+
+template <class F>
+struct is_constant_invocable<
+    F,
+    stdx::void_t<std::integral_constant<bool, (static_cast<void>(F{}()), true)>>>
+    : std::is_empty<F> {};
+
+// The outcome of a guard known at compile time.
+struct guard_dynamic {};
+struct guard_false {};
+struct guard_true {};
+
+template <class Guard, bool = is_constant_invocable<Guard>::value>
+struct guard_outcome {
+    using type = guard_dynamic;
+};
+
+template <class Guard>
+struct guard_outcome<Guard, true> {
+    using type = std::conditional_t<static_cast<bool>(Guard{}()), guard_true, guard_false>;
+};
+
+// The result of processing an event in a state, resolved when the table is compiled. A `dynamic`
+// cell calls a guard or action that must run, and is processed by the handler for its state.
+template <class StateIndex>
+struct lookup_cell {
+    process_status status;
+    StateIndex next;
+    bool external;
+    bool dynamic;
+};
+
+template <class StateIndexMap, class StateIndex>
+struct lookup_cell_builder {
+    using cell_type = lookup_cell<StateIndex>;
+
+    static constexpr auto resolved(process_status status) noexcept -> cell_type {
+        return {status, 0, false, false};
+    }
+
+    static constexpr auto dynamic() noexcept -> cell_type {
+        return {process_status::Completed, 0, false, true};
+    }
+
+    template <class... Transitions>
+    static constexpr auto row(const std::tuple<Transitions...>*) noexcept -> cell_type {
+        return transitions<Transitions...>();
+    }
+
+    // No guard succeeded.
+    template <class... Transitions, std::enable_if_t<sizeof...(Transitions) == 0, int> = 0>
+    static constexpr auto transitions() noexcept -> cell_type {
+        return resolved(process_status::GuardFailure);
+    }
+
+    template <class Transition, class... Transitions>
+    static constexpr auto transitions() noexcept -> cell_type {
+        return guarded<Transition, Transitions...>(
+            typename guard_outcome<typename Transition::guard_type>::type{});
+    }
+
+    template <class Transition, class... Transitions>
+    static constexpr auto guarded(guard_dynamic) noexcept -> cell_type {
+        return dynamic();
+    }
+
+    template <class Transition, class... Transitions>
+    static constexpr auto guarded(guard_false) noexcept -> cell_type {
+        return transitions<Transitions...>();
+    }
+
+    template <class Transition, class... Transitions>
+    static constexpr auto guarded(guard_true) noexcept -> cell_type {
+        return is_constant_invocable<typename Transition::action_type>::value ?
+                   taken<Transition>() :
+                   dynamic();
+    }
+
+    template <class Transition, std::enable_if_t<Transition::internal, int> = 0>
+    static constexpr auto taken() noexcept -> cell_type {
+        return resolved(std::is_same<typename Transition::action_type,
+                                     transition::detail::action_pass>::value ?
+                            process_status::EventIgnored :
+                            process_status::Completed);
+    }
+
+    template <class Transition, std::enable_if_t<!Transition::internal, int> = 0>
+    static constexpr auto taken() noexcept -> cell_type {
+        return {process_status::Completed,
+                static_cast<StateIndex>(
+                    StateIndexMap::template at_key<typename Transition::destination_type>::value),
+                true,
+                false};
+    }
+};
+
+template <class Table, class StateIndex, size_t K>
+constexpr auto make_lookup_cell(std::true_type /* undefined */) noexcept
+    -> lookup_cell<StateIndex> {
+    return lookup_cell_builder<typename Table::state_index_map, StateIndex>::resolved(
+        process_status::UndefinedTransition);
+}
+
+template <class Table, class StateIndex, size_t K>
+constexpr auto make_lookup_cell(std::false_type /* undefined */) noexcept
+    -> lookup_cell<StateIndex> {
+    using row_type = std::tuple_element_t<Table::transition_matrix[K], typename Table::data_type>;
+
+    return lookup_cell_builder<typename Table::state_index_map, StateIndex>::row(
+        static_cast<const typename row_type::data_type*>(nullptr));
+}
+
+// The cell for element `K` of the [state][event] matrix of `Table`.
+template <class Table, class StateIndex, size_t K>
+constexpr auto lookup_cell_at() noexcept -> lookup_cell<StateIndex> {
+    return make_lookup_cell<Table, StateIndex, K>(
+        stdx::bool_constant<Table::transition_matrix[K] == Table::undefined_row>{});
+}
+
+template <class Table, class StateIndex, size_t... Ks>
+constexpr auto make_lookup_cells(std::index_sequence<Ks...>) noexcept
+    -> std::array<lookup_cell<StateIndex>, sizeof...(Ks)> {
+    return {{lookup_cell_at<Table, StateIndex, Ks>()...}};
+}
+
+// Entry and exit actions of payload-free states, called by state index through a function table.
+template <class... States>
+struct lookup_hooks {
+    using hook_type = void (*)();
+
+    static constexpr bool any_on_exit = stdx::disjunction<has_on_exit<States>...>::value;
+
+    static constexpr auto has_entry(size_t index) noexcept -> bool {
+        constexpr bool flags[] = {has_on_entry<States>::value...};
+        return flags[index];
+    }
+
+    static constexpr auto has_exit(size_t index) noexcept -> bool {
+        constexpr bool flags[] = {has_on_exit<States>::value...};
+        return flags[index];
+    }
+
+    static auto on_entry(size_t index) -> void {
+        static constexpr hook_type hooks[] = {entry_hook<States>()...};
+
+        if (hooks[index] != nullptr) {
+            hooks[index]();
+        }
+    }
+
+    static auto on_exit(size_t index) -> void {
+        static constexpr hook_type hooks[] = {exit_hook<States>()...};
+
+        if (hooks[index] != nullptr) {
+            hooks[index]();
+        }
+    }
+
+  private:
+    template <class State>
+    static auto call_on_entry() -> void {
+        State s{};
+        detail::on_entry(s);
+    }
+
+    template <class State>
+    static auto call_on_exit() -> void {
+        State s{};
+        detail::on_exit(s);
+    }
+
+    template <class State, std::enable_if_t<has_on_entry<State>::value, int> = 0>
+    static constexpr auto entry_hook() noexcept -> hook_type {
+        return &call_on_entry<State>;
+    }
+
+    template <class State, std::enable_if_t<!has_on_entry<State>::value, int> = 0>
+    static constexpr auto entry_hook() noexcept -> hook_type {
+        return nullptr;
+    }
+
+    template <class State, std::enable_if_t<has_on_exit<State>::value, int> = 0>
+    static constexpr auto exit_hook() noexcept -> hook_type {
+        return &call_on_exit<State>;
+    }
+
+    template <class State, std::enable_if_t<!has_on_exit<State>::value, int> = 0>
+    static constexpr auto exit_hook() noexcept -> hook_type {
+        return nullptr;
+    }
+};
+
+// The index of the current state. If any state defines `on_exit`, it is called for the current
+// state on destruction, as a StateMachine does.
+template <class StateIndex, class Hooks, bool = Hooks::any_on_exit>
+struct lookup_state {
+    constexpr auto has_state() const noexcept -> bool { return true; }
+
+    StateIndex index;
+};
+
+// Moving leaves the moved-from index without a state, so `on_exit` is called once for a state that
+// is moved to another machine, by the machine holding it, as for a StateMachine.
+template <class StateIndex, class Hooks>
+struct lookup_state<StateIndex, Hooks, true> {
+    static constexpr StateIndex no_state = std::numeric_limits<StateIndex>::max();
+
+    explicit lookup_state(StateIndex i) noexcept : index{i} {}
+
+    lookup_state(lookup_state&& rhs) noexcept : index{rhs.index} { rhs.index = no_state; }
+
+    // NOLINTNEXTLINE(bugprone-exception-escape)
+    auto operator=(lookup_state&& rhs) noexcept -> lookup_state& {
+        if (this != &rhs) {
+            exit();
+            index = rhs.index;
+            rhs.index = no_state;
+        }
+        return *this;
+    }
+
+    lookup_state(const lookup_state&) = delete;
+    auto operator=(const lookup_state&) -> lookup_state& = delete;
+
+    // NOLINTNEXTLINE(bugprone-exception-escape)
+    ~lookup_state() { exit(); }
+
+    constexpr auto has_state() const noexcept -> bool { return index != no_state; }
+
+    StateIndex index;
+
+  private:
+    auto exit() -> void {
+        if (has_state()) {
+            Hooks::on_exit(index);
+        }
+    }
+};
+
+template <class StateIndex, class Hooks>
+constexpr StateIndex lookup_state<StateIndex, Hooks, true>::no_state;
+
+} // namespace detail
+
+
+// Check if every state of a Table is payload-free: empty, trivially default constructible and
+// trivially destructible. Such a Table can be used with `LookupStateMachine`.
+template <class Table>
+struct is_payload_free
+    : op::repack<typename detail::table_of<Table>::type::state_types, detail::all_payload_free> {};
+
+namespace detail {
+
+// A payload-free Table compiled into a [state][event] matrix of `lookup_cell`s, processing events
+// for a machine given the index of its current state. Shared by `LookupStateMachine` and
+// `LookupBatch`.
+template <class Table>
+class lookup_table : private table_holder<Table> {
+    using table_base = table_holder<Table>;
+
+  public:
+    using table_type = typename table_of<Table>::type;
+
+    static_assert(transition::is_table<table_type>::value,
+                  "A `LookupStateMachine` must be created from a `Table`");
+    static_assert(is_payload_free<table_type>::value,
+                  "A `LookupStateMachine` requires states that are empty, trivially default "
+                  "constructible and trivially destructible.");
+
+    using state_types = typename table_type::state_types;
+    using event_types = typename table_type::event_types;
+    using initial_state_type =
+        typename std::tuple_element_t<0, typename table_type::data_type>::source_type;
+
+    using state_index_type = std::conditional_t<
+        (table_type::num_states <= std::numeric_limits<uint8_t>::max()),
+        uint8_t,
+        uint16_t>;
+
+    using hooks = op::repack<state_types, lookup_hooks>;
+    using cell_type = lookup_cell<state_index_type>;
+
+    static constexpr size_t num_states = table_type::num_states;
+    static constexpr size_t num_events = table_type::num_events;
+
+    // The cells of the [state][event] matrix, flattened in row-major order.
+    static constexpr std::array<cell_type, num_states * num_events> cells =
+        make_lookup_cells<table_type, state_index_type>(
+            std::make_index_sequence<num_states * num_events>{});
+
+    lookup_table() = default;
+    explicit lookup_table(Table&& table) : table_base{std::forward<Table>(table)} {}
+
+    template <class Event>
+    static constexpr auto event_index() noexcept -> size_t {
+        return table_type::event_index_map::template at_key<std::decay_t<Event>>::value;
+    }
+
+    template <class State>
+    static constexpr auto state_index() noexcept -> state_index_type {
+        return table_type::state_index_map::template at_key<State>::value;
+    }
+
+    static constexpr auto initial_index() noexcept -> state_index_type {
+        return state_index<initial_state_type>();
+    }
+
+    // Process `event` for the machine in state `index`.
+    template <class Event>
+    auto process(state_index_type& index, Event&& event) const -> process_status {
+        const auto& cell = cells[(index * num_events) + event_index<Event>()];
+
+        if (cell.dynamic) {
+            return dispatch(
+                index, std::forward<Event>(event), std::make_index_sequence<num_states>{});
+        }
+
+        if (cell.external) {
+            hooks::on_exit(index);
+            index = cell.next;
+            hooks::on_entry(index);
+        }
+
+        return cell.status;
+    }
+
+    auto process_id(state_index_type& index, size_t event_index, const void* payload) const
+        -> process_status {
+        return dispatch_event_id(
+            index, event_index, payload, std::make_index_sequence<num_events>{});
+    }
+
+  private:
+    template <class Event>
+    using handler_type = process_status (*)(const lookup_table&, state_index_type&, Event&&);
+
+    template <class Event, size_t... Is>
+    auto dispatch(state_index_type& index, Event&& event, std::index_sequence<Is...>) const
+        -> process_status {
+        static constexpr handler_type<Event> handlers[] = {
+            &lookup_table::handle_state<Event, Is>...};
+
+        return handlers[index](*this, index, std::forward<Event>(event));
+    }
+
+    using event_id_handler_type = process_status (*)(const lookup_table&,
+                                                     state_index_type&,
+                                                     const void*);
+
+    template <size_t... Is>
+    auto dispatch_event_id(state_index_type& index,
+                           size_t event_index,
+                           const void* payload,
+                           std::index_sequence<Is...>) const -> process_status {
+        static constexpr event_id_handler_type handlers[] = {&lookup_table::handle_event_id<Is>...};
+
+        if (event_index >= sizeof...(Is)) {
+            return process_status::UndefinedTransition;
+        }
+
+        return handlers[event_index](*this, index, payload);
+    }
+
+    template <size_t I>
+    static auto handle_event_id(const lookup_table& self,
+                                state_index_type& index,
+                                const void* payload) -> process_status {
+        using event_type =
+            typename table_type::event_index_map::template at_value<aux::index_constant<I>>;
+
+        return self.process(index, detail::load_event<event_type>(payload));
+    }
+
+    // Only called for dynamic cells, which always have a row.
+    template <class Event, size_t I>
+    static auto handle_state(const lookup_table& self, state_index_type& index, Event&& event)
+        -> process_status {
+        constexpr auto row_index = table_type::row_index(I, event_index<Event>());
+
+        return self.get_row_transitions(
+            index,
+            std::forward<Event>(event),
+            std::integral_constant<typename table_type::row_index_type, row_index>{});
+    }
+
+    template <class Event,
+              class RowIndexConstant,
+              std::enable_if_t<RowIndexConstant::value == table_type::undefined_row, int> = 0>
+    auto get_row_transitions(state_index_type&, Event&&, RowIndexConstant) const
+        -> process_status {
+        return process_status::UndefinedTransition;
+    }
+
+    template <class Event,
+              class RowIndexConstant,
+              std::enable_if_t<RowIndexConstant::value != table_type::undefined_row, int> = 0>
+    auto get_row_transitions(state_index_type& index, Event&& event, RowIndexConstant) const
+        -> process_status {
+        const auto& row = std::get<RowIndexConstant::value>(this->table().data());
+        typename std::decay_t<decltype(row)>::source_type source{};
+
+        return find_transition(row,
+                               index,
+                               source,
+                               std::forward<Event>(event),
+                               std::make_index_sequence<std::decay_t<decltype(row)>::size>{});
+    }
+
+    template <class Row, class Event>
+    auto find_transition(const Row&,
+                         state_index_type&,
+                         typename Row::source_type&,
+                         Event&&,
+                         std::index_sequence<>) const -> process_status {
+        return process_status::GuardFailure;
+    }
+
+    template <class Row, class Event, size_t I, size_t... Is>
+    auto find_transition(const Row& row,
+                         state_index_type& index,
+                         typename Row::source_type& source,
+                         Event&& event,
+                         std::index_sequence<I, Is...>) const -> process_status {
+        const auto& transition = std::get<I>(row.data());
+
+        return transition.invoke_guard(source, event) ?
+                   do_transition(transition, index, source, std::forward<Event>(event)) :
+                   find_transition(row,
+                                   index,
+                                   source,
+                                   std::forward<Event>(event),
+                                   std::index_sequence<Is...>{});
+    }
+
+    template <class Transition, class Event, std::enable_if_t<Transition::internal, int> = 0>
+    auto do_transition(const Transition& transition,
+                       state_index_type&,
+                       typename Transition::source_type& source,
+                       Event&& event) const -> process_status {
+        if (std::is_same<typename Transition::action_type,
+                         transition::detail::action_pass>::value) {
+            return process_status::EventIgnored;
+        }
+
+        transition.invoke_action(source, std::forward<Event>(event));
+
+        return process_status::Completed;
+    }
+
+    template <class Transition, class Event, std::enable_if_t<!Transition::internal, int> = 0>
+    auto do_transition(const Transition& transition,
+                       state_index_type& index,
+                       typename Transition::source_type& source,
+                       Event&& event) const -> process_status {
+        using destination_type = typename Transition::destination_type;
+
+        detail::on_exit(source);
+
+        static_cast<void>(transition.invoke_action(source, std::forward<Event>(event)));
+
+        index = state_index<destination_type>();
+
+        destination_type destination{};
+        detail::on_entry(destination);
+
+        return process_status::Completed;
+    }
+};
+
+template <class Table>
+constexpr size_t lookup_table<Table>::num_states;
+
+template <class Table>
+constexpr size_t lookup_table<Table>::num_events;
+
+template <class Table>
+constexpr std::array<typename lookup_table<Table>::cell_type,
+                     lookup_table<Table>::num_states * lookup_table<Table>::num_events>
+    lookup_table<Table>::cells;
+
+} // namespace detail
+
+// A state machine for a Table whose states carry no data, holding only the index of its current
+// state.
+//
+// The result of each event in each state is resolved when the table is compiled into a
+// [state][event] matrix of cells holding the status to return and the next state. Guards and
+// actions that are stateless and callable without arguments in a constant expression are folded
+// into the cells, so for tables built from such guards and actions `process_event` is an array
+// lookup and a store. Transitions with other guards or actions are processed by calling them, with
+// the source state created on demand. Entry and exit actions are called through a function table
+// indexed by state.
+//
+// States returned by actions are discarded, as the machine only records the destination index.
+//
+// If a state defines `on_exit`, a moved-from machine is left without a state, for which events are
+// reported as an `InvalidState`.
+template <class Table>
+class LookupStateMachine : private detail::lookup_table<Table> {
+    using lookup_base = detail::lookup_table<Table>;
+
+  public:
+    using type = LookupStateMachine<Table>;
+    using typename lookup_base::event_types;
+    using typename lookup_base::initial_state_type;
+    using typename lookup_base::state_index_type;
+    using typename lookup_base::state_types;
+    using typename lookup_base::table_type;
+
+    explicit LookupStateMachine(Table&& table)
+        : lookup_base{std::forward<Table>(table)}, state_{lookup_base::initial_index()} {
+        hooks::on_entry(state_.index);
+    }
+
+    // Create a LookupStateMachine for a `static_table`.
+    template <class T = Table, std::enable_if_t<detail::is_static_table<T>::value, int> = 0>
+    LookupStateMachine() : state_{lookup_base::initial_index()} {
+        hooks::on_entry(state_.index);
+    }
+
+    LookupStateMachine(LookupStateMachine&&) noexcept = default;
+    auto operator=(LookupStateMachine&&) noexcept -> LookupStateMachine& = default;
+
+    LookupStateMachine(const LookupStateMachine&) = delete;
+    auto operator=(const LookupStateMachine&) -> LookupStateMachine& = delete;
+
+    ~LookupStateMachine() = default;
+
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto process_event(Event&& event) -> process_status {
+        if (!state_.has_state()) {
+            return process_status::InvalidState;
+        }
+        return this->process(state_.index, std::forward<Event>(event));
+    }
+
+    // Process an event identified by its index in `event_types`, as `StateMachine` does.
+    auto process_event_id(size_t event_index, const void* payload) -> process_status {
+        if (!state_.has_state()) {
+            return process_status::InvalidState;
+        }
+        return this->process_id(state_.index, event_index, payload);
+    }
+
+    // The index of `Event` in `event_types`, for use with `process_event_id`.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    static constexpr auto event_index() noexcept -> size_t {
+        return lookup_base::template event_index<Event>();
+    }
+
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    constexpr auto is_state() const noexcept -> bool {
+        return state_.index == lookup_base::template state_index<State>();
+    }
+
+    // The index of the current state in `state_types`.
+    constexpr auto state_index() const noexcept -> size_t { return state_.index; }
+
+  private:
+    using typename lookup_base::hooks;
+
+    detail::lookup_state<state_index_type, hooks> state_;
+};
+
+template <class Table>
+constexpr auto make_lookup_state_machine(Table&& table) -> LookupStateMachine<Table> {
+    return LookupStateMachine<Table>{std::forward<Table>(table)};
+}
+
+} // namespace state_machine
+} // namespace state_machine
@@ -0,0 +1,601 @@
+#pragma once
+
+#include "state_machine/backport.h"
+#include "state_machine/containers.h"
+#include "state_machine/error.h"
+#include "state_machine/state_machine.h"
+#include "state_machine/traits.h"
+#include "state_machine/transition/transition.h"
+#include "state_machine/transition/transition_table.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace state_machine {
+namespace state_machine {
+
+namespace detail {
+
+// The states of all machines in a MachinePool, with one array per state type. `on_exit` is called
+// for every state held when the arrays are destroyed or replaced by move assignment.
+template <class... States>
+class pool_payloads {
+  public:
+    pool_payloads() = default;
+
+    // A moved-from vector is empty, so `rhs` no longer holds any state.
+    pool_payloads(pool_payloads&&) noexcept = default;
+    auto operator=(pool_payloads&& rhs) noexcept -> pool_payloads& {
+        if (this != &rhs) {
+            exit_all();
+            arrays_ = std::exchange(rhs.arrays_, {});
+        }
+        return *this;
+    }
+
+    pool_payloads(const pool_payloads&) = delete;
+    auto operator=(const pool_payloads&) -> pool_payloads& = delete;
+
+    ~pool_payloads() { exit_all(); }
+
+    template <class State>
+    auto get() noexcept -> std::vector<State>& {
+        return std::get<std::vector<State>>(arrays_);
+    }
+
+    template <class State>
+    auto get() const noexcept -> const std::vector<State>& {
+        return std::get<std::vector<State>>(arrays_);
+    }
+
+  private:
+    auto exit_all() -> void {
+        static_cast<void>(std::initializer_list<int>{(exit_state<States>(), 0)...});
+    }
+
+    template <class State, std::enable_if_t<!has_on_exit<State>::value, int> = 0>
+    auto exit_state() -> void {}
+
+    template <class State, std::enable_if_t<has_on_exit<State>::value, int> = 0>
+    auto exit_state() -> void {
+        for (auto& s : get<State>()) {
+            on_exit(s);
+        }
+    }
+
+    std::tuple<std::vector<States>...> arrays_;
+};
+
+// Append a `T` constructed from `args` to `v`. Aggregates are initialized with braces, as states
+// held in a Variant are.
+template <class T,
+          class... Args,
+          std::enable_if_t<std::is_constructible<T, Args...>::value, int> = 0>
+auto emplace_back(std::vector<T>& v, Args&&... args) -> T& {
+    v.emplace_back(std::forward<Args>(args)...);
+    return v.back();
+}
+
+template <class T,
+          class... Args,
+          std::enable_if_t<!std::is_constructible<T, Args...>::value, int> = 0>
+auto emplace_back(std::vector<T>& v, Args&&... args) -> T& {
+    v.push_back(T{std::forward<Args>(args)...});
+    return v.back();
+}
+
+} // namespace detail
+
+// A container of many state machines sharing one Table, stored as a structure of arrays.
+//
+// Each machine is identified by a `handle_type` that stays valid until the machine is destroyed.
+// The pool keeps a dense array of the index of the current state of each machine, and for each
+// state type a contiguous array holding the states of the machines currently in that state. A
+// machine that leaves a state is removed from the array of that state by moving the last element
+// into its place, so the arrays stay dense and scanning or processing events for all machines in
+// one state touches only that state's storage.
+//
+// The slots of destroyed machines are reused by later calls to `create`. A handle holds the index
+// of its slot in the low 32 bits and the generation of the slot in the high 32 bits. The
+// generation is incremented when a machine is destroyed, so a stale handle is not taken for the
+// machine later created in the same slot, until the generation wraps around.
+template <class Table>
+class MachinePool : private detail::table_holder<Table> {
+    using table_base = detail::table_holder<Table>;
+
+  public:
+    using table_type = typename detail::table_of<Table>::type;
+
+    static_assert(transition::is_table<table_type>::value,
+                  "A `MachinePool` must be created from a `Table`");
+
+    using type = MachinePool<Table>;
+    using state_types = typename table_type::state_types;
+    using event_types = typename table_type::event_types;
+    using initial_state_type =
+        typename std::tuple_element_t<0, typename table_type::data_type>::source_type;
+
+    using handle_type = uint64_t;
+
+    // The index of the state of a machine, where 0 is a destroyed machine and `1 + I` is state `I`
+    // of `state_types`, as for `Variant::index`.
+    using state_index_type = std::conditional_t<
+        (table_type::num_states < std::numeric_limits<uint8_t>::max()),
+        uint8_t,
+        uint16_t>;
+
+    explicit MachinePool(Table&& table) : table_base{std::forward<Table>(table)} {}
+
+    // Create a MachinePool for a `static_table`.
+    template <class T = Table, std::enable_if_t<detail::is_static_table<T>::value, int> = 0>
+    MachinePool() {}
+
+    MachinePool(MachinePool&&) noexcept = default;
+    auto operator=(MachinePool&&) noexcept -> MachinePool& = default;
+
+    MachinePool(const MachinePool&) = delete;
+    auto operator=(const MachinePool&) -> MachinePool& = delete;
+
+    // `on_exit` is called for the current state of every machine by `payloads_`, on destruction
+    // and for the machines replaced by move assignment.
+    ~MachinePool() = default;
+
+    // Create a machine with its initial state constructed from `args`. If the constructor throws,
+    // no machine is created.
+    template <class... Args>
+    auto create(Args&&... args) -> handle_type {
+        const auto slot = reserve_slot();
+        const auto h = make_handle(slot, slots_[slot].generation);
+
+        auto& s = emplace_payload<initial_state_type>(h, std::forward<Args>(args)...);
+        free_.pop_back();
+
+        detail::on_entry(s);
+        return h;
+    }
+
+    // Destroy the machine `h`, calling `on_exit` for its current state.
+    auto destroy(handle_type h) -> void {
+        if (!contains(h)) {
+            return;
+        }
+
+        const auto slot = slot_of(h);
+        destroy_impl(h, std::make_index_sequence<table_type::num_states>{});
+        states_[slot] = 0;
+        ++slots_[slot].generation;
+        free_.push_back(slot);
+    }
+
+    auto contains(handle_type h) const noexcept -> bool {
+        const auto slot = slot_of(h);
+        return (slot < states_.size()) && (states_[slot] != 0) &&
+               (slots_[slot].generation == generation_of(h));
+    }
+
+    // The number of machines.
+    auto size() const noexcept -> size_t { return states_.size() - free_.size(); }
+
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto count() const noexcept -> size_t {
+        return payloads<State>().size();
+    }
+
+    // The index of the current state of machine `h`, or 0 if `h` was destroyed.
+    auto state_index(handle_type h) const noexcept -> size_t {
+        return contains(h) ? states_[slot_of(h)] : 0;
+    }
+
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto is_state(handle_type h) const noexcept -> bool {
+        return state_index(h) == state_index_of<State>();
+    }
+
+    // The current state of machine `h`, which must be `State`.
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto get(handle_type h) -> State& {
+        if (!is_state<State>(h)) {
+            error::raise(bad_state_access{});
+        }
+        return payloads_of<State>()[position_of(h)];
+    }
+
+    // The states of all machines in `State`, in no particular order.
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto payloads() const noexcept -> const std::vector<State>& {
+        return payloads_.template get<State>();
+    }
+
+    // The handles of all machines in `State`, in the order of `payloads<State>()`.
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto handles() const noexcept -> const std::vector<handle_type>& {
+        return owners_[state_index_of<State>() - 1];
+    }
+
+    // Call `f(handle, state)` for every machine in `State`.
+    template <class State,
+              class F,
+              std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto for_each(F&& f) -> void {
+        auto& states = payloads_of<State>();
+        const auto& owners = handles<State>();
+        for (size_t i = 0; i < states.size(); ++i) {
+            f(owners[i], states[i]);
+        }
+    }
+
+    // Process `event` for machine `h`. A destroyed machine reports `InvalidState`.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto process_event(handle_type h, Event&& event) -> process_status {
+        if (!contains(h)) {
+            return process_status::InvalidState;
+        }
+
+        return dispatch(h,
+                        std::forward<Event>(event),
+                        std::make_index_sequence<1 + table_type::num_states>{});
+    }
+
+    // Process `event` for every machine in `State`, touching only the states of those machines.
+    // Machines that transition to another state are not processed again. Returns the number of
+    // machines for which a transition completed.
+    template <class State,
+              class Event,
+              std::enable_if_t<op::contains<State, state_types>::value &&
+                                   op::contains<std::decay_t<Event>, event_types>::value,
+                               int> = 0>
+    auto process_event_in(const Event& event) -> size_t {
+        return process_in<State>(event, payloads<State>().size());
+    }
+
+    // Process `event` for every machine, one state at a time. Only the storage of states with a
+    // transition for `event` is touched. Returns the number of machines for which a transition
+    // completed.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto process_event_all(const Event& event) -> size_t {
+        return process_all(event, std::make_index_sequence<table_type::num_states>{});
+    }
+
+  private:
+    using payloads_type = op::repack<state_types, detail::pool_payloads>;
+
+    // The position of the state of the machine in a slot in the array of its state type, and the
+    // generation of the slot.
+    struct slot_type {
+        uint32_t position = 0;
+        uint32_t generation = 0;
+    };
+
+    static constexpr unsigned generation_shift = 32;
+
+    static auto make_handle(size_t slot, uint32_t generation) noexcept -> handle_type {
+        return (static_cast<handle_type>(generation) << generation_shift) | slot;
+    }
+
+    static auto slot_of(handle_type h) noexcept -> uint32_t { return static_cast<uint32_t>(h); }
+
+    static auto generation_of(handle_type h) noexcept -> uint32_t {
+        return static_cast<uint32_t>(h >> generation_shift);
+    }
+
+    auto position_of(handle_type h) const noexcept -> uint32_t {
+        return slots_[slot_of(h)].position;
+    }
+
+    template <class State>
+    static constexpr auto state_index_of() noexcept -> size_t {
+        return 1 + table_type::state_index_map::template at_key<State>::value;
+    }
+
+    template <size_t I>
+    using state_at =
+        typename table_type::state_index_map::template at_value<aux::index_constant<I>>;
+
+    template <class State>
+    auto payloads_of() noexcept -> std::vector<State>& {
+        return payloads_.template get<State>();
+    }
+
+    template <class State>
+    auto owners_of() noexcept -> std::vector<handle_type>& {
+        return owners_[state_index_of<State>() - 1];
+    }
+
+    // The free slot for the next machine, adding one if there is none. The slot stays in `free_`
+    // until the machine is created, so a constructor that throws leaves it free.
+    auto reserve_slot() -> size_t {
+        if (free_.empty()) {
+            const auto slot = states_.size();
+
+            // Keep room in `free_` for every slot, so `destroy` does not allocate.
+            if (free_.capacity() <= slot) {
+                free_.reserve((2 * slot) + 1);
+            }
+            // `slots_` may be longer than `states_` if growing `states_` threw before.
+            if (slots_.size() <= slot) {
+                slots_.resize(slot + 1);
+            }
+            states_.push_back(0);
+            free_.push_back(static_cast<uint32_t>(slot));
+        }
+        return free_.back();
+    }
+
+    // Append a state for machine `h` and make it the current state of `h`.
+    template <class State, class... Args>
+    auto emplace_payload(handle_type h, Args&&... args) -> State& {
+        auto& states = payloads_of<State>();
+        auto& owners = owners_of<State>();
+
+        // Grow `owners` before `states`, so an owner can be appended without throwing once the
+        // state is constructed. The capacity is doubled to keep appends amortized constant time.
+        if (owners.size() == owners.capacity()) {
+            owners.reserve((2 * owners.size()) + 1);
+        }
+        auto& s = detail::emplace_back(states, std::forward<Args>(args)...);
+        owners.push_back(h);
+
+        states_[slot_of(h)] = static_cast<state_index_type>(state_index_of<State>());
+        slots_[slot_of(h)].position = static_cast<uint32_t>(states.size() - 1);
+        return s;
+    }
+
+    // Remove the state at `position` by moving the last state of the array into its place.
+    template <class State>
+    auto remove_payload(size_t position) -> void {
+        auto& states = payloads_of<State>();
+        auto& owners = owners_of<State>();
+
+        if (position + 1 != states.size()) {
+            states[position] = std::move(states.back());
+            owners[position] = owners.back();
+            slots_[slot_of(owners[position])].position = static_cast<uint32_t>(position);
+        }
+
+        states.pop_back();
+        owners.pop_back();
+    }
+
+    template <size_t... Is>
+    auto destroy_impl(handle_type h, std::index_sequence<Is...>) -> void {
+        using destroyer_type = void (*)(MachinePool&, handle_type);
+        static constexpr destroyer_type destroyers[] = {&type::destroy_state<state_at<Is>>...};
+
+        destroyers[states_[slot_of(h)] - 1](*this, h);
+    }
+
+    template <class State>
+    static auto destroy_state(MachinePool& self, handle_type h) -> void {
+        detail::on_exit(self.template payloads_of<State>()[self.position_of(h)]);
+        self.template remove_payload<State>(self.position_of(h));
+    }
+
+    template <class Event>
+    using handler_type = process_status (*)(MachinePool&, handle_type, Event&&);
+
+    template <class Event, size_t... Is>
+    auto dispatch(handle_type h, Event&& event, std::index_sequence<Is...>) -> process_status {
+        static constexpr handler_type<Event> handlers[] = {&type::handle_state<Event, Is>...};
+
+        return handlers[states_[slot_of(h)]](*this, h, std::forward<Event>(event));
+    }
+
+    template <class Event, size_t I, std::enable_if_t<I == 0, int> = 0>
+    static auto handle_state(MachinePool&, handle_type, Event&&) -> process_status {
+        return process_status::InvalidState;
+    }
+
+    template <class Event, size_t I, std::enable_if_t<I != 0, int> = 0>
+    static auto handle_state(MachinePool& self, handle_type h, Event&& event) -> process_status {
+        return self.template process_in_state<state_at<I - 1>>(h, std::forward<Event>(event));
+    }
+
+    template <class State, class Event>
+    static constexpr auto row_index() noexcept -> typename table_type::row_index_type {
+        return table_type::row_index(
+            state_index_of<State>() - 1,
+            table_type::event_index_map::template at_key<std::decay_t<Event>>::value);
+    }
+
+    template <class State, class Event>
+    auto process_in_state(handle_type h, Event&& event) -> process_status {
+        return get_row_transitions<State>(
+            h,
+            std::forward<Event>(event),
+            std::integral_constant<typename table_type::row_index_type,
+                                   row_index<State, Event>()>{});
+    }
+
+    template <class State,
+              class Event,
+              class RowIndexConstant,
+              std::enable_if_t<RowIndexConstant::value == table_type::undefined_row, int> = 0>
+    auto get_row_transitions(handle_type, Event&&, RowIndexConstant) -> process_status {
+        return process_status::UndefinedTransition;
+    }
+
+    template <class State,
+              class Event,
+              class RowIndexConstant,
+              std::enable_if_t<RowIndexConstant::value != table_type::undefined_row, int> = 0>
+    auto get_row_transitions(handle_type h, Event&& event, RowIndexConstant) -> process_status {
+        const auto& row = std::get<RowIndexConstant::value>(this->table().data());
+
+        return find_transition(h,
+                               row,
+                               std::forward<Event>(event),
+                               std::make_index_sequence<std::decay_t<decltype(row)>::size>{});
+    }
+
+    template <class Row, class Event>
+    auto find_transition(handle_type, const Row&, Event&&, std::index_sequence<>)
+        -> process_status {
+        return process_status::GuardFailure;
+    }
+
+    template <class Row, class Event, size_t I, size_t... Is>
+    auto find_transition(handle_type h,
+                         const Row& row,
+                         Event&& event,
+                         std::index_sequence<I, Is...>) -> process_status {
+        const auto& transition = std::get<I>(row.data());
+        const auto& state = payloads_of<typename Row::source_type>()[position_of(h)];
+
+        return transition.invoke_guard(state, event) ?
+                   do_transition(h, transition, std::forward<Event>(event)) :
+                   find_transition(
+                       h, row, std::forward<Event>(event), std::index_sequence<Is...>{});
+    }
+
+    // Perform an internal transition
+    template <class Transition, class Event, std::enable_if_t<Transition::internal, int> = 0>
+    auto do_transition(handle_type h, const Transition& transition, Event&& event)
+        -> process_status {
+        if (std::is_same<typename Transition::action_type,
+                         transition::detail::action_pass>::value) {
+            return process_status::EventIgnored;
+        }
+
+        auto& s = payloads_of<typename Transition::source_type>()[position_of(h)];
+        transition.invoke_action(s, std::forward<Event>(event));
+
+        return process_status::Completed;
+    }
+
+    // Perform an external self-transition marked `reuse`, reusing the state in place
+    template <class Transition, class Event, std::enable_if_t<Transition::self, int> = 0>
+    auto do_transition(handle_type h, const Transition& transition, Event&& event)
+        -> process_status {
+        auto& s = payloads_of<typename Transition::source_type>()[position_of(h)];
+
+        detail::on_exit(s);
+        assign_state(s, transition.invoke_action(s, std::forward<Event>(event)));
+        detail::on_entry(s);
+
+        return process_status::Completed;
+    }
+
+    // Perform an external transition. The destination is appended to the array of its state before
+    // the source is removed, so a destination that fails to construct leaves the machine in its
+    // source state. Removing the source may move the destination, if both are in the same array.
+    template <class Transition,
+              class Event,
+              std::enable_if_t<!Transition::internal && !Transition::self, int> = 0>
+    auto do_transition(handle_type h, const Transition& transition, Event&& event)
+        -> process_status {
+        using source_type = typename Transition::source_type;
+        using destination_type = typename Transition::destination_type;
+
+        const auto position = position_of(h);
+        auto& s = payloads_of<source_type>()[position];
+
+        detail::on_exit(s);
+
+        auto&& destination = transition.invoke_action(s, std::forward<Event>(event));
+        emplace_destination<destination_type>(h, std::forward<decltype(destination)>(destination));
+
+        remove_payload<source_type>(position);
+
+        detail::on_entry(payloads_of<destination_type>()[position_of(h)]);
+
+        return process_status::Completed;
+    }
+
+    template <class State, class Destination>
+    auto assign_state(State&, Destination&) -> void {}
+
+    template <class State,
+              class Destination,
+              std::enable_if_t<!transition::is_in_place_construct<Destination>::value &&
+                                   !std::is_lvalue_reference<Destination>::value,
+                               int> = 0>
+    auto assign_state(State& s, Destination&& destination) -> void {
+        s = std::forward<Destination>(destination);
+    }
+
+    template <class State,
+              class Destination,
+              std::enable_if_t<transition::is_in_place_construct<Destination>::value, int> = 0>
+    auto assign_state(State& s, Destination&& destination) -> void {
+        s = std::move(destination).apply(
+            [](auto&&... args) { return State(std::forward<decltype(args)>(args)...); });
+    }
+
+    template <class State,
+              class Destination,
+              std::enable_if_t<!transition::is_in_place_construct<Destination>::value, int> = 0>
+    auto emplace_destination(handle_type h, Destination&& destination) -> State& {
+        return emplace_payload<State>(h, std::forward<Destination>(destination));
+    }
+
+    template <class State,
+              class Destination,
+              std::enable_if_t<transition::is_in_place_construct<Destination>::value, int> = 0>
+    auto emplace_destination(handle_type h, Destination&& destination) -> State& {
+        return std::move(destination).apply([this, h](auto&&... args) -> State& {
+            return this->template emplace_payload<State>(h, std::forward<decltype(args)>(args)...);
+        });
+    }
+
+    // Process `event` for the first `count` machines in `State`, from the last to the first. A
+    // machine leaving the state is replaced by the last element of the array, which was either
+    // processed already or entered the state during this call.
+    template <class State, class Event>
+    auto process_in(const Event& event, size_t count) -> size_t {
+        size_t completed = 0;
+        for (auto i = count; i > 0; --i) {
+            const auto h = owners_of<State>()[i - 1];
+            if (process_in_state<State>(h, event) == process_status::Completed) {
+                ++completed;
+            }
+        }
+        return completed;
+    }
+
+    template <class Event, size_t... Is>
+    auto process_all(const Event& event, std::index_sequence<Is...>) -> size_t {
+        // Record the number of machines in each state first, so that machines entering a state
+        // are not processed again.
+        const std::array<size_t, sizeof...(Is)> counts = {{payloads<state_at<Is>>().size()...}};
+
+        size_t completed = 0;
+        static_cast<void>(std::initializer_list<int>{
+            (completed += process_all_in<state_at<Is>>(event, counts[Is]), 0)...});
+        return completed;
+    }
+
+    template <class State,
+              class Event,
+              std::enable_if_t<row_index<State, Event>() == table_type::undefined_row, int> = 0>
+    auto process_all_in(const Event&, size_t) -> size_t {
+        return 0;
+    }
+
+    template <class State,
+              class Event,
+              std::enable_if_t<row_index<State, Event>() != table_type::undefined_row, int> = 0>
+    auto process_all_in(const Event& event, size_t count) -> size_t {
+        return process_in<State>(event, count);
+    }
+
+    std::vector<state_index_type> states_;
+    std::vector<slot_type> slots_;
+    std::vector<uint32_t> free_;
+    payloads_type payloads_;
+    std::array<std::vector<handle_type>, table_type::num_states> owners_;
+};
+
+template <class Table>
+constexpr unsigned MachinePool<Table>::generation_shift;
+
+} // namespace state_machine
+} // namespace state_machine
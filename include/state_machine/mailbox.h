@@ -0,0 +1,301 @@
+#pragma once
+
+#include "state_machine/containers.h"
+#include "state_machine/spsc_queue.h"
+#include "state_machine/state_machine.h"
+#include "state_machine/variant.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace state_machine {
+namespace state_machine {
+
+// What `Mailbox::post` does when the mailbox is full.
+enum overflow_policy : uint8_t {
+    // Yield until a slot is free.
+    Block,
+    // Discard the oldest queued event to make room, at most one per post.
+    DropOldest,
+    // Discard the posted event.
+    DropNewest,
+    // Return without posting, leaving the posted event to the caller.
+    Reject
+};
+
+// The return type for `Mailbox::post`.
+enum post_status : uint8_t { Posted, DroppedOldest, DroppedNewest, Rejected };
+
+// A bounded lock-free mailbox of events for one state machine of a Table, posted to by any number
+// of producer threads and drained by the thread owning the machine.
+//
+// Each slot holds a `Variant` over the `event_types` of the Table and a sequence number. A producer
+// claims the tail slot with a compare-and-swap on the tail index and publishes the event by
+// advancing the sequence number of the slot, so producers never wait for each other, nor for the
+// consumer unless the mailbox is full under the `Block` policy. `drain(machine, budget)` claims up
+// to `batch_size` published events with one compare-and-swap on the head index, moves them out of
+// their slots and frees the slots, then processes the events in order, each to completion. No slot
+// is held while an action runs. Under `DropOldest`, a producer finding the mailbox full claims the
+// oldest event the same way and discards it, which frees the slot at the tail.
+//
+// Events posted by one producer are processed in the order they were posted. If `process_event`
+// throws, the exception propagates from `drain` and the other events of the same batch are
+// discarded.
+template <class Table, overflow_policy Overflow = overflow_policy::Block>
+class Mailbox {
+  public:
+    using table_type = typename detail::table_of<Table>::type;
+    using event_types = typename table_type::event_types;
+
+    // The type holding a posted event of any of the `event_types`.
+    using event_type = op::repack<event_types, variant::Variant>;
+
+    static constexpr overflow_policy overflow = Overflow;
+
+    static constexpr size_t default_capacity = 1024;
+
+    // The largest number of events claimed from the mailbox at once.
+    static constexpr size_t batch_size = 64;
+
+    // Create a mailbox holding at least `capacity` events. The capacity is rounded up to a power
+    // of two.
+    explicit Mailbox(size_t capacity = default_capacity)
+        : mask_{detail::ceil_power_of_two(capacity) - 1},
+          slots_{new slot[mask_ + 1]},
+          batch_{new event_type[batch_size]} {
+        for (size_t i = 0; i <= mask_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    Mailbox(const Mailbox&) = delete;
+    auto operator=(const Mailbox&) -> Mailbox& = delete;
+    Mailbox(Mailbox&&) = delete;
+    auto operator=(Mailbox&&) -> Mailbox& = delete;
+
+    ~Mailbox() = default;
+
+    // Append `event`, applying the overflow policy if the mailbox is full. The event is only moved
+    // from if it is posted. May be called by any thread.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto post(Event&& event) -> post_status {
+        auto status = post_status::Posted;
+        while (true) {
+            size_t position = 0;
+            if (claim_tail(position)) {
+                const publish p{slots_[position & mask_], position + 1};
+                p.s.event.template emplace<std::decay_t<Event>>(std::forward<Event>(event));
+                return status;
+            }
+
+            if (Overflow == overflow_policy::DropNewest) {
+                dropped_.value.fetch_add(1, std::memory_order_relaxed);
+                return post_status::DroppedNewest;
+            }
+            if (Overflow == overflow_policy::Reject) {
+                return post_status::Rejected;
+            }
+            // Discard at most one event per post. The tail slot may still be held briefly by a
+            // producer publishing its event or by the consumer moving events out of their slots.
+            if ((Overflow == overflow_policy::DropOldest) && (status == post_status::Posted) &&
+                (take(1, [](event_type&) {}) != 0)) {
+                dropped_.value.fetch_add(1, std::memory_order_relaxed);
+                status = post_status::DroppedOldest;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Process up to `budget` posted events with `machine`, in batches of at most `batch_size`.
+    // Returns the number of events processed. Called by the thread owning `machine`.
+    template <class Machine>
+    auto drain(Machine& machine, size_t budget = std::numeric_limits<size_t>::max()) -> size_t {
+        return drain(machine, budget, [](process_status) {});
+    }
+
+    // Process up to `budget` posted events with `machine` as above, calling `on_processed` with
+    // the result of each `process_event`.
+    template <class Machine, class F>
+    auto drain(Machine& machine, size_t budget, F&& on_processed) -> size_t {
+        size_t processed = 0;
+        while (processed < budget) {
+            const auto remaining = budget - processed;
+
+            size_t taken = 0;
+            const clear_batch guard{batch_.get(), taken};
+            const auto count =
+                take((remaining < batch_size) ? remaining : batch_size,
+                     [this, &taken](event_type& event) { batch_[taken++] = std::move(event); });
+            if (count == 0) {
+                break;
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                // An event whose constructor threw in `post` leaves its slot empty.
+                if (!batch_[i].template holds<variant::empty>()) {
+                    on_processed(batch_[i].visit(
+                        [&machine](auto& e) { return machine.process_event(std::move(e)); }));
+                }
+            }
+            processed += count;
+        }
+        return processed;
+    }
+
+    auto capacity() const noexcept -> size_t { return mask_ + 1; }
+
+    // The number of events discarded by the `DropOldest` and `DropNewest` policies.
+    auto dropped() const noexcept -> uint64_t {
+        return dropped_.value.load(std::memory_order_relaxed);
+    }
+
+    // Check if the mailbox is empty. Exact only when no producer is running.
+    auto empty() const noexcept -> bool {
+        return head_.value.load(std::memory_order_acquire) ==
+               tail_.value.load(std::memory_order_acquire);
+    }
+
+  private:
+    struct slot {
+        // Equal to the position of the slot when it is free for that position, and to the
+        // position plus one once the event for that position is published.
+        std::atomic<size_t> sequence{0};
+        event_type event;
+    };
+
+    // Destroys the events moved out of their slots by `drain`, including those left unprocessed
+    // when `process_event` throws.
+    struct clear_batch {
+        event_type* events;
+        const size_t& size;
+
+        ~clear_batch() {
+            for (size_t i = 0; i < size; ++i) {
+                events[i].template emplace<variant::empty>();
+            }
+        }
+    };
+
+    // Publishes the event of a claimed slot, even if constructing the event throws.
+    struct publish {
+        slot& s;
+        size_t sequence;
+
+        ~publish() { s.sequence.store(sequence, std::memory_order_release); }
+    };
+
+    // The distance of the sequence number of a slot from `expected`.
+    static auto lag(size_t sequence, size_t expected) noexcept -> std::ptrdiff_t {
+        return static_cast<std::ptrdiff_t>(sequence - expected);
+    }
+
+    // Claim the slot at the tail. Returns false if the mailbox is full.
+    auto claim_tail(size_t& position) -> bool {
+        auto tail = tail_.value.load(std::memory_order_relaxed);
+        while (true) {
+            const auto d = lag(slots_[tail & mask_].sequence.load(std::memory_order_acquire), tail);
+            if (d < 0) {
+                return false;
+            }
+            if (d > 0) {
+                tail = tail_.value.load(std::memory_order_relaxed);
+            } else if (tail_.value.compare_exchange_weak(tail, tail + 1,
+                                                         std::memory_order_relaxed)) {
+                position = tail;
+                return true;
+            }
+        }
+    }
+
+    // Claim up to `max_count` published events at the head and call `f(event_type&)` for each in
+    // order, freeing each slot after `f` returns. Returns the number of events claimed.
+    template <class F>
+    auto take(size_t max_count, F&& f) -> size_t {
+        auto head = head_.value.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (true) {
+            count = 0;
+            while (count < max_count) {
+                const auto position = head + count;
+                const auto& s = slots_[position & mask_];
+                if (lag(s.sequence.load(std::memory_order_acquire), position + 1) != 0) {
+                    break;
+                }
+                ++count;
+            }
+
+            if (count == 0) {
+                const auto d =
+                    lag(slots_[head & mask_].sequence.load(std::memory_order_acquire), head + 1);
+                if (d < 0) {
+                    return 0;
+                }
+                // Another thread claimed the head first.
+                head = head_.value.load(std::memory_order_relaxed);
+            } else if (head_.value.compare_exchange_weak(head, head + count,
+                                                         std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        // Free the claimed slots from the event for which `f` throws, if it does.
+        struct free_slots {
+            Mailbox& mailbox;
+            size_t& position;
+            size_t end;
+
+            ~free_slots() {
+                for (; position != end; ++position) {
+                    mailbox.free_slot(position);
+                }
+            }
+        };
+
+        auto position = head;
+        const free_slots guard{*this, position, head + count};
+        for (; position != head + count; ++position) {
+            f(slots_[position & mask_].event);
+            free_slot(position);
+        }
+        return count;
+    }
+
+    // Destroy the event at `position` and free its slot for the position one lap later.
+    auto free_slot(size_t position) noexcept -> void {
+        auto& s = slots_[position & mask_];
+        s.event.template emplace<variant::empty>();
+        s.sequence.store(position + mask_ + 1, std::memory_order_release);
+    }
+
+    // Read by all threads but never written after construction.
+    const size_t mask_;
+    std::unique_ptr<slot[]> slots_;
+    char padding_[detail::cache_line_size] = {};
+
+    detail::cache_padded<std::atomic<size_t>> tail_{};
+    detail::cache_padded<std::atomic<size_t>> head_{};
+    detail::cache_padded<std::atomic<uint64_t>> dropped_{};
+
+    // The events claimed by `drain`, used only by the thread owning the machine.
+    std::unique_ptr<event_type[]> batch_;
+};
+
+template <class Table, overflow_policy Overflow>
+constexpr overflow_policy Mailbox<Table, Overflow>::overflow;
+
+template <class Table, overflow_policy Overflow>
+constexpr size_t Mailbox<Table, Overflow>::default_capacity;
+
+template <class Table, overflow_policy Overflow>
+constexpr size_t Mailbox<Table, Overflow>::batch_size;
+
+} // namespace state_machine
+} // namespace state_machine
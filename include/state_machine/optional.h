@@ -1,5 +1,8 @@
 #pragma once
 
+#include "state_machine/error.h"
+
+#include <exception>
 #include <type_traits>
 
 namespace state_machine {
@@ -110,7 +113,7 @@ class optional_base {
   private:
     inline void throw_if_empty() const {
         if (!bool(*this)) {
-            throw bad_optional_access{};
+            error::raise(bad_optional_access{});
         }
     }
 
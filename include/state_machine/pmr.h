@@ -0,0 +1,306 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__has_include)
+#if (__cplusplus >= 201703L) && __has_include(<memory_resource>)
+#include <memory_resource>
+#define STATE_MACHINE_HAS_STD_PMR 1
+#endif
+#endif
+
+#ifndef STATE_MACHINE_HAS_STD_PMR
+#include "state_machine/error.h"
+
+#include <atomic>
+#endif
+
+namespace state_machine {
+namespace pmr {
+
+#ifdef STATE_MACHINE_HAS_STD_PMR
+
+using std::pmr::get_default_resource;
+using std::pmr::memory_resource;
+using std::pmr::monotonic_buffer_resource;
+using std::pmr::new_delete_resource;
+using std::pmr::polymorphic_allocator;
+using std::pmr::set_default_resource;
+
+// The allocator passed to states and actions by a StateMachine using `pmr_policy`.
+using allocator = polymorphic_allocator<std::byte>;
+
+#else
+
+// Backport of std::pmr::memory_resource (C++17)
+// NOLINTNEXTLINE(cppcoreguidelines-special-member-functions,hicpp-special-member-functions)
+class memory_resource {
+    static constexpr std::size_t max_align = alignof(std::max_align_t);
+
+  public:
+    memory_resource() = default;
+    memory_resource(const memory_resource&) = default;
+    auto operator=(const memory_resource&) -> memory_resource& = default;
+    virtual ~memory_resource() = default;
+
+    auto allocate(std::size_t bytes, std::size_t alignment = max_align) -> void* {
+        return do_allocate(bytes, alignment);
+    }
+
+    auto deallocate(void* p, std::size_t bytes, std::size_t alignment = max_align) -> void {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    auto is_equal(const memory_resource& other) const noexcept -> bool {
+        return do_is_equal(other);
+    }
+
+  private:
+    virtual auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* = 0;
+    virtual auto do_deallocate(void* p, std::size_t bytes, std::size_t alignment) -> void = 0;
+    virtual auto do_is_equal(const memory_resource& other) const noexcept -> bool = 0;
+};
+
+inline auto operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept -> bool {
+    return (&lhs == &rhs) || lhs.is_equal(rhs);
+}
+
+inline auto operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept -> bool {
+    return !(lhs == rhs);
+}
+
+namespace detail {
+
+class new_delete_resource_impl final : public memory_resource {
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override {
+        // Over-aligned allocation requires C++17.
+        if (alignment > alignof(std::max_align_t)) {
+            error::raise(std::bad_alloc{});
+        }
+        return ::operator new(bytes);
+    }
+
+    auto do_deallocate(void* p, std::size_t, std::size_t) -> void override { ::operator delete(p); }
+
+    auto do_is_equal(const memory_resource& other) const noexcept -> bool override {
+        return this == &other;
+    }
+};
+
+} // namespace detail
+
+// Backport of std::pmr::new_delete_resource (C++17)
+inline auto new_delete_resource() noexcept -> memory_resource* {
+    static detail::new_delete_resource_impl resource{};
+    return &resource;
+}
+
+namespace detail {
+
+inline auto default_resource() noexcept -> std::atomic<memory_resource*>& {
+    static std::atomic<memory_resource*> current{new_delete_resource()};
+    return current;
+}
+
+} // namespace detail
+
+// Backport of std::pmr::get_default_resource (C++17)
+inline auto get_default_resource() noexcept -> memory_resource* {
+    return detail::default_resource().load();
+}
+
+// Backport of std::pmr::set_default_resource (C++17)
+inline auto set_default_resource(memory_resource* r) noexcept -> memory_resource* {
+    return detail::default_resource().exchange((r != nullptr) ? r : new_delete_resource());
+}
+
+// Backport of std::pmr::polymorphic_allocator (C++17)
+template <class T>
+class polymorphic_allocator {
+  public:
+    using value_type = T;
+
+    polymorphic_allocator() noexcept : resource_{get_default_resource()} {}
+
+    // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+    polymorphic_allocator(memory_resource* r) noexcept : resource_{r} {}
+
+    polymorphic_allocator(const polymorphic_allocator&) = default;
+
+    template <class U>
+    // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+        : resource_{other.resource()} {}
+
+    auto operator=(const polymorphic_allocator&) -> polymorphic_allocator& = delete;
+
+    ~polymorphic_allocator() = default;
+
+    auto allocate(std::size_t n) -> T* {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    auto deallocate(T* p, std::size_t n) -> void {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    // Construct `U` with uses-allocator construction, so that allocator-aware elements use the same
+    // memory resource as the container.
+    template <class U, class... Args>
+    auto construct(U* p, Args&&... args) -> void {
+        construct_impl(uses_allocator_tag<U, Args...>{}, p, std::forward<Args>(args)...);
+    }
+
+    auto select_on_container_copy_construction() const -> polymorphic_allocator {
+        return polymorphic_allocator{};
+    }
+
+    auto resource() const noexcept -> memory_resource* { return resource_; }
+
+  private:
+    struct construct_leading {};
+    struct construct_trailing {};
+    struct construct_plain {};
+
+    template <class U, class... Args>
+    using uses_allocator_tag = std::conditional_t<
+        std::uses_allocator<U, polymorphic_allocator>::value &&
+            std::is_constructible<U, std::allocator_arg_t, polymorphic_allocator, Args...>::value,
+        construct_leading,
+        std::conditional_t<std::uses_allocator<U, polymorphic_allocator>::value &&
+                               std::is_constructible<U, Args..., polymorphic_allocator>::value,
+                           construct_trailing,
+                           construct_plain>>;
+
+    template <class U, class... Args>
+    auto construct_impl(construct_leading, U* p, Args&&... args) -> void {
+        ::new (static_cast<void*>(p)) U(std::allocator_arg, *this, std::forward<Args>(args)...);
+    }
+
+    template <class U, class... Args>
+    auto construct_impl(construct_trailing, U* p, Args&&... args) -> void {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)..., *this);
+    }
+
+    template <class U, class... Args>
+    auto construct_impl(construct_plain, U* p, Args&&... args) -> void {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    memory_resource* resource_;
+};
+
+template <class T, class U>
+auto operator==(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept
+    -> bool {
+    return *lhs.resource() == *rhs.resource();
+}
+
+template <class T, class U>
+auto operator!=(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept
+    -> bool {
+    return !(lhs == rhs);
+}
+
+// Backport of std::pmr::monotonic_buffer_resource (C++17)
+//
+// Memory is handed out from a buffer by bumping a pointer and is only returned by `release` or
+// destruction, which makes allocation cheap and reset of all allocations O(number of chunks).
+class monotonic_buffer_resource : public memory_resource {
+    static constexpr std::size_t default_chunk_size = 1024;
+
+  public:
+    explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_{upstream} {}
+
+    explicit monotonic_buffer_resource(std::size_t initial_size,
+                                       memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_{upstream}, next_chunk_size_{(initial_size > 0) ? initial_size : 1} {}
+
+    monotonic_buffer_resource(void* buffer,
+                              std::size_t buffer_size,
+                              memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_{upstream},
+          initial_buffer_{buffer},
+          initial_buffer_size_{buffer_size},
+          current_{buffer},
+          space_{buffer_size} {}
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource(monotonic_buffer_resource&&) = delete;
+    auto operator=(const monotonic_buffer_resource&) -> monotonic_buffer_resource& = delete;
+    auto operator=(monotonic_buffer_resource&&) -> monotonic_buffer_resource& = delete;
+
+    ~monotonic_buffer_resource() override { release(); }
+
+    // Return all memory allocated from upstream and restart from the initial buffer, if any.
+    auto release() -> void {
+        while (chunks_ != nullptr) {
+            auto* next = chunks_->next;
+            upstream_->deallocate(chunks_, chunks_->size, alignof(chunk));
+            chunks_ = next;
+        }
+        current_ = initial_buffer_;
+        space_ = initial_buffer_size_;
+    }
+
+    auto upstream_resource() const noexcept -> memory_resource* { return upstream_; }
+
+  private:
+    struct chunk {
+        chunk* next;
+        std::size_t size;
+    };
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override {
+        auto* p = std::align(alignment, bytes, current_, space_);
+        if (p == nullptr) {
+            allocate_chunk(bytes + alignment);
+            p = std::align(alignment, bytes, current_, space_);
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        current_ = static_cast<unsigned char*>(p) + bytes;
+        space_ -= bytes;
+        return p;
+    }
+
+    auto do_deallocate(void*, std::size_t, std::size_t) -> void override {}
+
+    auto do_is_equal(const memory_resource& other) const noexcept -> bool override {
+        return this == &other;
+    }
+
+    auto allocate_chunk(std::size_t min_bytes) -> void {
+        while (next_chunk_size_ < min_bytes) {
+            next_chunk_size_ *= 2;
+        }
+
+        const auto size = sizeof(chunk) + next_chunk_size_;
+        chunks_ = ::new (upstream_->allocate(size, alignof(chunk))) chunk{chunks_, size};
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        current_ = chunks_ + 1;
+        space_ = next_chunk_size_;
+        next_chunk_size_ *= 2;
+    }
+
+    memory_resource* upstream_;
+    void* initial_buffer_ = nullptr;
+    std::size_t initial_buffer_size_ = 0;
+    void* current_ = nullptr;
+    std::size_t space_ = 0;
+    std::size_t next_chunk_size_ = default_chunk_size;
+    chunk* chunks_ = nullptr;
+};
+
+// The allocator passed to states and actions by a StateMachine using `pmr_policy`.
+using allocator = polymorphic_allocator<unsigned char>;
+
+#endif
+
+} // namespace pmr
+} // namespace state_machine
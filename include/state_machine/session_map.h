@@ -0,0 +1,289 @@
+#pragma once
+
+#include "state_machine/containers.h"
+#include "state_machine/error.h"
+#include "state_machine/machine_pool.h"
+#include "state_machine/state_machine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace state_machine {
+namespace state_machine {
+
+namespace detail {
+
+// Spread the bits of a hash over the high bits used to index a table of `2^bits` slots (Fibonacci
+// hashing), so that hashes which are identities for integers, such as `std::hash<uint64_t>` in
+// common implementations, do not place sequential keys in sequential slots.
+inline auto spread_hash(size_t hash, unsigned bits) noexcept -> size_t {
+    constexpr uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    const uint64_t h = hash;
+    return (h * multiplier) >> (64U - bits);
+}
+
+// An open-addressing hash table with linear probing from keys to values, which must both be default
+// constructible, since unused slots hold default constructed keys and values. Erasing shifts later
+// slots of the probe sequence back instead of leaving tombstones, so lookups do not slow down as
+// keys come and go.
+template <class Key, class Value, class Hash>
+class key_index {
+  public:
+    static_assert(std::is_default_constructible<Key>::value &&
+                      std::is_default_constructible<Value>::value,
+                  "The keys and values of a `key_index` must be default constructible.");
+
+    explicit key_index(const Hash& hash) : hash_{hash} {}
+
+    auto find(const Key& key) -> Value* {
+        const auto i = find_slot(key);
+        return (i == npos) ? nullptr : &slots_[i].value;
+    }
+
+    auto find(const Key& key) const -> const Value* {
+        const auto i = find_slot(key);
+        return (i == npos) ? nullptr : &slots_[i].value;
+    }
+
+    // The value of `key`, inserting `make_value()` if there is none.
+    template <class F>
+    auto find_or_insert(const Key& key, F&& make_value) -> Value& {
+        const auto found = find_slot(key);
+        if (found != npos) {
+            return slots_[found].value;
+        }
+
+        // Only a new key may grow the table.
+        if (!fits(size_ + 1, bits_)) {
+            rehash((bits_ == 0) ? min_bits : bits_ + 1);
+        }
+
+        auto i = home(key);
+        while (slots_[i].full) {
+            i = (i + 1) & mask();
+        }
+
+        slots_[i] = slot{key, std::forward<F>(make_value)(), true};
+        ++size_;
+        return slots_[i].value;
+    }
+
+    auto erase(const Key& key) -> bool {
+        const auto i = find_slot(key);
+        if (i == npos) {
+            return false;
+        }
+        erase_slot(i);
+        return true;
+    }
+
+    auto size() const noexcept -> size_t { return size_; }
+
+    // Make room for `count` keys without rehashing.
+    auto reserve(size_t count) -> void {
+        auto bits = bits_;
+        while (!fits(count, bits)) {
+            ++bits;
+        }
+        if (bits != bits_) {
+            rehash(bits);
+        }
+    }
+
+  private:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+    static constexpr unsigned min_bits = 4;
+
+    struct slot {
+        Key key;
+        Value value;
+        bool full;
+    };
+
+    // At most 3/4 of the slots are used.
+    static constexpr auto fits(size_t count, unsigned bits) noexcept -> bool {
+        return (bits > 0) && (count * 4 <= (size_t{1} << bits) * 3);
+    }
+
+    auto mask() const noexcept -> size_t { return slots_.size() - 1; }
+
+    auto home(const Key& key) const -> size_t { return spread_hash(hash_(key), bits_); }
+
+    auto find_slot(const Key& key) const -> size_t {
+        if (slots_.empty()) {
+            return npos;
+        }
+
+        for (auto i = home(key);; i = (i + 1) & mask()) {
+            if (!slots_[i].full) {
+                return npos;
+            }
+            if (slots_[i].key == key) {
+                return i;
+            }
+        }
+    }
+
+    // Empty slot `i` and move back any later slots of the probe sequence that would no longer be
+    // reachable from their home slot.
+    auto erase_slot(size_t i) -> void {
+        auto j = i;
+        while (true) {
+            j = (j + 1) & mask();
+            if (!slots_[j].full) {
+                break;
+            }
+
+            // Slot `j` may fill the hole at `i` unless its home lies cyclically in (i, j].
+            const auto k = home(slots_[j].key);
+            const auto reachable = (i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j));
+            if (!reachable) {
+                slots_[i] = std::move(slots_[j]);
+                i = j;
+            }
+        }
+
+        slots_[i].full = false;
+        --size_;
+    }
+
+    auto rehash(unsigned bits) -> void {
+        std::vector<slot> old(size_t{1} << bits, slot{Key{}, Value{}, false});
+        old.swap(slots_);
+        bits_ = bits;
+
+        for (auto& s : old) {
+            if (!s.full) {
+                continue;
+            }
+
+            auto i = home(s.key);
+            while (slots_[i].full) {
+                i = (i + 1) & mask();
+            }
+            slots_[i] = std::move(s);
+        }
+    }
+
+    Hash hash_;
+    std::vector<slot> slots_;
+    unsigned bits_ = 0;
+    size_t size_ = 0;
+};
+
+template <class Key, class Value, class Hash>
+constexpr size_t key_index<Key, Value, Hash>::npos;
+
+template <class Key, class Value, class Hash>
+constexpr unsigned key_index<Key, Value, Hash>::min_bits;
+
+template <class Terminal, class Pool>
+struct is_terminal {
+    static auto check(const Pool& pool, typename Pool::handle_type h) noexcept -> bool {
+        return pool.template is_state<Terminal>(h);
+    }
+};
+
+template <class Pool>
+struct is_terminal<void, Pool> {
+    static auto check(const Pool&, typename Pool::handle_type) noexcept -> bool { return false; }
+};
+
+} // namespace detail
+
+// A map from keys, such as connection ids, to state machines of one Table.
+//
+// Keys are held in an open-addressing hash table with linear probing, alongside the handle of each
+// machine in a `MachinePool`, so a lookup reads one contiguous array of slots and allocates
+// nothing. `process_event(key, event)` creates the machine for a new key in its initial state. If
+// `Terminal` is a state, a machine reaching that state is erased. `Key` must be default
+// constructible, as well as equality comparable and hashable with `Hash`.
+template <class Key, class Table, class Terminal = void, class Hash = std::hash<Key>>
+class SessionMap {
+  public:
+    using key_type = Key;
+    using hasher = Hash;
+    using pool_type = MachinePool<Table>;
+    using handle_type = typename pool_type::handle_type;
+    using state_types = typename pool_type::state_types;
+    using event_types = typename pool_type::event_types;
+    using terminal_state_type = Terminal;
+
+    static_assert(std::is_void<Terminal>::value || op::contains<Terminal, state_types>::value,
+                  "The terminal state of a `SessionMap` must be a state of its Table.");
+
+    explicit SessionMap(Table&& table, const Hash& hash = Hash{})
+        : pool_{std::forward<Table>(table)}, index_{hash} {}
+
+    // Create a SessionMap for a `static_table`.
+    template <class T = Table, std::enable_if_t<detail::is_static_table<T>::value, int> = 0>
+    explicit SessionMap(const Hash& hash = Hash{}) : index_{hash} {}
+
+    // Process `event` for the machine of `key`, creating it in its initial state if there is
+    // none. The machine is erased if it reaches the terminal state.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto process_event(const Key& key, Event&& event) -> process_status {
+        const auto h = index_.find_or_insert(key, [this] { return pool_.create(); });
+        const auto status = pool_.process_event(h, std::forward<Event>(event));
+
+        if (detail::is_terminal<Terminal, pool_type>::check(pool_, h)) {
+            erase(key);
+        }
+        return status;
+    }
+
+    // Erase the machine of `key`, calling `on_exit` for its current state. Returns whether there
+    // was a machine for `key`.
+    auto erase(const Key& key) -> bool {
+        const auto* h = index_.find(key);
+        if (h == nullptr) {
+            return false;
+        }
+
+        pool_.destroy(*h);
+        index_.erase(key);
+        return true;
+    }
+
+    auto contains(const Key& key) const -> bool { return index_.find(key) != nullptr; }
+
+    auto size() const noexcept -> size_t { return index_.size(); }
+    auto empty() const noexcept -> bool { return size() == 0; }
+
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto is_state(const Key& key) const -> bool {
+        const auto* h = index_.find(key);
+        return (h != nullptr) && pool_.template is_state<State>(*h);
+    }
+
+    // The current state of the machine of `key`, which must exist and be in `State`.
+    template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
+    auto get(const Key& key) -> State& {
+        const auto* h = index_.find(key);
+        if (h == nullptr) {
+            error::raise(bad_state_access{});
+        }
+        return pool_.template get<State>(*h);
+    }
+
+    // The machines, for scanning the machines in one state with `count`, `payloads` or `handles`.
+    // Events are processed through `process_event`, which erases the machines that
+    // reach the terminal state.
+    auto machines() const noexcept -> const pool_type& { return pool_; }
+
+    // Make room for `count` keys without rehashing.
+    auto reserve(size_t count) -> void { index_.reserve(count); }
+
+  private:
+    pool_type pool_;
+    detail::key_index<Key, handle_type, Hash> index_;
+};
+
+} // namespace state_machine
+} // namespace state_machine
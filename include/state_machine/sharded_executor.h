@@ -0,0 +1,610 @@
+#pragma once
+
+#include "state_machine/containers.h"
+#include "state_machine/session_map.h"
+#include "state_machine/spsc_queue.h"
+#include "state_machine/state_machine.h"
+#include "state_machine/variant.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace state_machine {
+namespace state_machine {
+
+namespace detail {
+
+// Storage for objects of type `T` that never moves them once constructed. Each object starts on its
+// own cache line, so objects used by different threads never share one. Objects are allocated in
+// chunks, and the storage of erased objects is reused.
+template <class T>
+class cache_aligned_slots {
+  public:
+    using index_type = uint32_t;
+
+    static_assert(alignof(T) <= cache_line_size,
+                  "`cache_aligned_slots` cannot hold over-aligned types.");
+
+    cache_aligned_slots() = default;
+
+    cache_aligned_slots(const cache_aligned_slots&) = delete;
+    auto operator=(const cache_aligned_slots&) -> cache_aligned_slots& = delete;
+    cache_aligned_slots(cache_aligned_slots&&) = delete;
+    auto operator=(cache_aligned_slots&&) -> cache_aligned_slots& = delete;
+
+    ~cache_aligned_slots() {
+        for (index_type i = 0; i < live_.size(); ++i) {
+            if (live_[i]) {
+                (*this)[i].~T();
+            }
+        }
+    }
+
+    template <class... Args>
+    auto emplace(Args&&... args) -> index_type {
+        index_type i;
+        if (!free_.empty()) {
+            i = free_.back();
+            free_.pop_back();
+        } else {
+            i = static_cast<index_type>(live_.size());
+            if (i % chunk_size == 0) {
+                chunks_.emplace_back();
+            }
+            live_.push_back(false);
+        }
+
+        ::new (address(i)) T(std::forward<Args>(args)...);
+        live_[i] = true;
+        ++size_;
+        return i;
+    }
+
+    auto erase(index_type i) -> void {
+        (*this)[i].~T();
+        live_[i] = false;
+        free_.push_back(i);
+        --size_;
+    }
+
+    auto operator[](index_type i) noexcept -> T& { return *static_cast<T*>(address(i)); }
+
+    auto size() const noexcept -> size_t { return size_; }
+
+    // Call `f(index, T&)` for each object.
+    template <class F>
+    auto for_each(F&& f) -> void {
+        for (index_type i = 0; i < live_.size(); ++i) {
+            if (live_[i]) {
+                f(i, (*this)[i]);
+            }
+        }
+    }
+
+  private:
+    static constexpr size_t chunk_size = 64;
+    static constexpr size_t stride = cache_line_multiple(sizeof(T));
+
+    // A buffer of `chunk_size` slots, starting at the first cache line boundary in the allocation.
+    class chunk {
+      public:
+        chunk() : buffer_{new unsigned char[chunk_size * stride + cache_line_size]} {
+            void* p = buffer_.get();
+            auto space = chunk_size * stride + cache_line_size;
+            base_ = static_cast<unsigned char*>(
+                std::align(cache_line_size, chunk_size * stride, p, space));
+        }
+
+        auto slot(size_t i) const noexcept -> void* { return base_ + i * stride; }
+
+      private:
+        std::unique_ptr<unsigned char[]> buffer_;
+        unsigned char* base_;
+    };
+
+    auto address(index_type i) const noexcept -> void* {
+        return chunks_[i / chunk_size].slot(i % chunk_size);
+    }
+
+    std::vector<chunk> chunks_;
+    std::vector<bool> live_;
+    std::vector<index_type> free_;
+    size_t size_ = 0;
+};
+
+template <class T>
+constexpr size_t cache_aligned_slots<T>::chunk_size;
+
+template <class T>
+constexpr size_t cache_aligned_slots<T>::stride;
+
+// Run `thread` on processor `cpu`, where supported.
+inline auto pin_to_cpu(std::thread& thread, size_t cpu) noexcept -> void {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    static_cast<void>(pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set));
+#else
+    static_cast<void>(thread);
+    static_cast<void>(cpu);
+#endif
+}
+
+} // namespace detail
+
+// Runs state machines of one Table on a fixed set of worker threads, one per shard.
+//
+// Each key, such as a session id, is assigned to a home shard by its hash, and the machine for the
+// key is created in its initial state by the shard's thread when the first event for the key
+// arrives. Events are posted by a fixed number of producer threads, each identified by an index
+// below `num_producers`. Every shard has one single-producer single-consumer queue per producer, so
+// posting an event never takes a lock or contends with other producers.
+//
+// A machine is only accessed by the thread of the shard holding it, which processes each event to
+// completion before taking the next one, so `process_event` never runs concurrently for one
+// machine. Events from one producer for one key are processed in the order they were posted.
+// Machines are stored each on its own cache lines, and the queue indices written by producers and
+// by the shard are kept on separate cache lines.
+//
+// `rebalance` compares the number of events processed by each shard since the previous call. If
+// the busiest shard exceeds the mean by more than a threshold, its thread moves its busiest
+// machines to the least busy shard between two events. A migrated machine is moved, together with
+// its current state, through a queue from the home shard to the new shard, and the home shard then
+// forwards the events for its key through the same queue, so they are processed in order. Only
+// machines on their home shard are migrated, so an event is forwarded at most once.
+template <class Table, class Key = uint64_t, class Hash = std::hash<Key>>
+class ShardedExecutor : private detail::table_holder<Table> {
+    using table_base = detail::table_holder<Table>;
+
+  public:
+    using table_type = typename detail::table_of<Table>::type;
+    using state_types = typename table_type::state_types;
+    using event_types = typename table_type::event_types;
+    using machine_type = StateMachine<Table>;
+    using key_type = Key;
+
+    // The type holding a posted event of any of the `event_types`.
+    using event_type = op::repack<event_types, variant::Variant>;
+
+    static constexpr size_t default_queue_capacity = 1024;
+
+    // The number of events a shard processes from one queue before moving to the next.
+    static constexpr size_t batch_size = 64;
+
+    ShardedExecutor(Table&& table,
+                    size_t num_shards,
+                    size_t num_producers,
+                    size_t queue_capacity = default_queue_capacity,
+                    const Hash& hash = Hash{})
+        : table_base{std::forward<Table>(table)}, hash_{hash} {
+        make_shards(num_shards, num_producers, queue_capacity);
+    }
+
+    // Create a ShardedExecutor for a `static_table`.
+    template <class T = Table, std::enable_if_t<detail::is_static_table<T>::value, int> = 0>
+    ShardedExecutor(size_t num_shards,
+                    size_t num_producers,
+                    size_t queue_capacity = default_queue_capacity,
+                    const Hash& hash = Hash{})
+        : hash_{hash} {
+        make_shards(num_shards, num_producers, queue_capacity);
+    }
+
+    ShardedExecutor(const ShardedExecutor&) = delete;
+    auto operator=(const ShardedExecutor&) -> ShardedExecutor& = delete;
+    ShardedExecutor(ShardedExecutor&&) = delete;
+    auto operator=(ShardedExecutor&&) -> ShardedExecutor& = delete;
+
+    ~ShardedExecutor() { stop(); }
+
+    // Start the thread of each shard. With `pin_threads`, the thread of shard `i` is pinned to
+    // processor `i` modulo the number of processors, where supported.
+    auto start(bool pin_threads = true) -> void {
+        if (running_.exchange(true)) {
+            return;
+        }
+
+        const auto num_cpus = std::thread::hardware_concurrency();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            auto& s = *shards_[i];
+            s.thread = std::thread{[this, &s] { run(s); }};
+            if (pin_threads && (num_cpus != 0)) {
+                detail::pin_to_cpu(s.thread, i % num_cpus);
+            }
+        }
+    }
+
+    // Process all events posted before the call, including events being forwarded to migrated
+    // machines, then stop the thread of each shard. Machines are kept and the executor may be
+    // started again.
+    auto stop() -> void {
+        if (!running_.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        stopping_.store(true, std::memory_order_release);
+        for (auto& s : shards_) {
+            while (!s->drained.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+        while (in_flight_.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+
+        running_.store(false, std::memory_order_release);
+        for (auto& s : shards_) {
+            s->thread.join();
+            s->drained.store(false, std::memory_order_relaxed);
+        }
+        stopping_.store(false, std::memory_order_relaxed);
+    }
+
+    auto running() const noexcept -> bool { return running_.load(std::memory_order_relaxed); }
+
+    // Post `event` for the machine of `key` from producer `producer`. Returns false without posting
+    // if the queue from the producer to the home shard of `key` is full.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto try_post(size_t producer, const Key& key, Event&& event) -> bool {
+        auto& queue = *shards_[shard_of(key)]->queues[producer];
+        return queue.try_emplace(key, std::forward<Event>(event));
+    }
+
+    // Post `event` for the machine of `key` from producer `producer`, yielding while the queue is
+    // full. The executor must be running if the queue may be full.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto post(size_t producer, const Key& key, const Event& event) -> void {
+        while (!try_post(producer, key, event)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // The home shard of `key`.
+    auto shard_of(const Key& key) const -> size_t {
+        return detail::spread_hash(hash_(key), 32) % shards_.size();
+    }
+
+    auto num_shards() const noexcept -> size_t { return shards_.size(); }
+    auto num_producers() const noexcept -> size_t { return shards_.front()->queues.size(); }
+
+    // The number of events processed by each shard, including events for migrated machines.
+    auto processed() const -> std::vector<uint64_t> {
+        std::vector<uint64_t> counts;
+        for (const auto& s : shards_) {
+            counts.push_back(s->processed.value.load(std::memory_order_relaxed));
+        }
+        return counts;
+    }
+
+    // The number of machines migrated from their home shard.
+    auto migrations() const noexcept -> size_t {
+        return migrations_.load(std::memory_order_relaxed);
+    }
+
+    // Migrate machines from the busiest shard to the least busy shard if the number of events
+    // processed by the busiest shard since the previous call exceeds the mean by more than
+    // `threshold` times. Machines are chosen by the number of events they processed over the same
+    // period, busiest first, moving at most half of the difference between the two shards. Returns
+    // whether machines may be migrated. Must not be called concurrently with itself.
+    auto rebalance(double threshold = 1.25) -> bool {
+        const auto counts = processed();
+        if (window_start_.empty()) {
+            window_start_.assign(counts.size(), 0);
+        }
+
+        std::vector<uint64_t> loads;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            loads.push_back(counts[i] - window_start_[i]);
+        }
+        window_start_ = counts;
+
+        const auto hot = static_cast<size_t>(std::max_element(loads.begin(), loads.end()) -
+                                             loads.begin());
+        const auto cold = static_cast<size_t>(std::min_element(loads.begin(), loads.end()) -
+                                              loads.begin());
+
+        uint64_t total = 0;
+        for (auto load : loads) {
+            total += load;
+        }
+        const auto mean = static_cast<double>(total) / static_cast<double>(loads.size());
+        const auto migrate = (hot != cold) && (static_cast<double>(loads[hot]) > threshold * mean);
+
+        // The command is published by the change of epoch, which also starts a new period for the
+        // event counts of the machines of each shard.
+        if (migrate) {
+            auto& s = *shards_[hot];
+            s.migrate_budget.store((loads[hot] - loads[cold]) / 2, std::memory_order_relaxed);
+            s.migrate_to.store(cold, std::memory_order_relaxed);
+        }
+        epoch_.fetch_add(1, std::memory_order_release);
+        return migrate;
+    }
+
+    // The following may only be called while the executor is stopped.
+
+    // The machine of `key`, or `nullptr` if no event was processed for `key`.
+    auto find(const Key& key) -> machine_type* {
+        auto* s = shards_[shard_of(key)].get();
+        if (const auto* to = s->forwards.find(key)) {
+            s = shards_[*to].get();
+        }
+
+        const auto* i = s->index.find(key);
+        return (i == nullptr) ? nullptr : &s->machines[*i].machine;
+    }
+
+    // The number of machines.
+    auto size() const noexcept -> size_t {
+        size_t count = 0;
+        for (const auto& s : shards_) {
+            count += s->machines.size();
+        }
+        return count;
+    }
+
+  private:
+    static constexpr size_t no_shard = std::numeric_limits<size_t>::max();
+
+    struct message {
+        template <class Event>
+        message(const Key& k, Event&& e) : key{k} {
+            event.template emplace<std::decay_t<Event>>(std::forward<Event>(e));
+        }
+
+        Key key;
+        event_type event;
+    };
+
+    // A message between shards, holding either a migrated machine or an event forwarded to it.
+    struct transfer {
+        Key key;
+        event_type event;
+        std::unique_ptr<machine_type> machine;
+        uint64_t events;
+    };
+
+    struct entry {
+        template <class... Args>
+        explicit entry(const Key& k, Args&&... args)
+            : key{k}, machine(std::forward<Args>(args)...) {}
+
+        Key key;
+        // The number of events processed in the current period.
+        uint64_t events = 0;
+        machine_type machine;
+    };
+
+    using queue_type = detail::spsc_ring<message>;
+    using link_type = detail::spsc_ring<transfer>;
+    using slot_index = typename detail::cache_aligned_slots<entry>::index_type;
+
+    struct shard {
+        shard(size_t shard_id,
+              size_t num_shards,
+              size_t num_producers,
+              size_t queue_capacity,
+              const Hash& hash)
+            : id{shard_id}, index{hash}, forwards{hash}, pending(num_shards) {
+            for (size_t i = 0; i < num_producers; ++i) {
+                queues.emplace_back(new queue_type{queue_capacity});
+            }
+            for (size_t i = 0; i < num_shards; ++i) {
+                links.emplace_back((i == shard_id) ? nullptr : new link_type{queue_capacity});
+            }
+        }
+
+        const size_t id;
+        std::vector<std::unique_ptr<queue_type>> queues;
+        // The queues from each other shard.
+        std::vector<std::unique_ptr<link_type>> links;
+        detail::cache_aligned_slots<entry> machines;
+        detail::key_index<Key, slot_index, Hash> index;
+        // The shards holding the machines migrated from this shard.
+        detail::key_index<Key, size_t, Hash> forwards;
+        // Transfers to each other shard waiting for room in its queue.
+        std::vector<std::deque<transfer>> pending;
+        uint64_t epoch = 0;
+        std::thread thread;
+
+        detail::cache_padded<std::atomic<uint64_t>> processed{};
+        std::atomic<size_t> migrate_to{no_shard};
+        std::atomic<uint64_t> migrate_budget{0};
+        std::atomic<bool> drained{false};
+    };
+
+    auto make_shards(size_t num_shards, size_t num_producers, size_t queue_capacity) -> void {
+        for (size_t i = 0; i < num_shards; ++i) {
+            shards_.emplace_back(new shard{i, num_shards, num_producers, queue_capacity, hash_});
+        }
+    }
+
+    // A copy of the table for a new machine, or a reference if `Table` is a reference.
+    auto copy_table() const -> Table { return this->table(); }
+
+    auto create_machine(shard& s, const Key& key) -> slot_index {
+        return create_machine(s, key, detail::is_static_table<Table>{});
+    }
+
+    auto create_machine(shard& s, const Key& key, std::true_type) -> slot_index {
+        return s.machines.emplace(key);
+    }
+
+    auto create_machine(shard& s, const Key& key, std::false_type) -> slot_index {
+        return s.machines.emplace(key, copy_table());
+    }
+
+    auto process(shard& s, slot_index i, event_type& event) -> void {
+        auto& e = s.machines[i];
+        event.visit([&e](auto& ev) { e.machine.process_event(std::move(ev)); });
+        ++e.events;
+
+        auto& processed = s.processed.value;
+        processed.store(processed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Process an event posted by a producer, or forward it to the shard its machine migrated to.
+    auto receive(shard& s, message& m) -> void {
+        if (const auto* to = s.forwards.find(m.key)) {
+            in_flight_.fetch_add(1, std::memory_order_relaxed);
+            send(s, *to, transfer{m.key, std::move(m.event), nullptr, 0});
+            return;
+        }
+
+        const auto i =
+            s.index.find_or_insert(m.key, [this, &s, &m] { return create_machine(s, m.key); });
+        process(s, i, m.event);
+    }
+
+    // Take a migrated machine, or process an event forwarded to it.
+    auto receive(shard& s, transfer& t) -> void {
+        if (t.machine) {
+            const auto i = s.machines.emplace(t.key, std::move(*t.machine));
+            s.machines[i].events = t.events;
+            s.index.find_or_insert(t.key, [i] { return i; });
+        } else {
+            const auto i =
+                s.index.find_or_insert(t.key, [this, &s, &t] { return create_machine(s, t.key); });
+            process(s, i, t.event);
+        }
+        in_flight_.fetch_sub(1, std::memory_order_release);
+    }
+
+    auto send(shard& s, size_t to, transfer&& t) -> void {
+        auto& pending = s.pending[to];
+        if (!pending.empty() || !shards_[to]->links[s.id]->try_emplace(std::move(t))) {
+            pending.push_back(std::move(t));
+        }
+    }
+
+    auto flush_pending(shard& s) -> void {
+        for (size_t to = 0; to < s.pending.size(); ++to) {
+            auto& pending = s.pending[to];
+            while (!pending.empty() &&
+                   shards_[to]->links[s.id]->try_emplace(std::move(pending.front()))) {
+                pending.pop_front();
+            }
+        }
+    }
+
+    // Move the busiest machines homed on `s` to shard `to`, up to `budget` events of the current
+    // period.
+    auto migrate(shard& s, size_t to, uint64_t budget) -> void {
+        std::vector<std::pair<uint64_t, slot_index>> candidates;
+        s.machines.for_each([this, &s, &candidates](slot_index i, entry& e) {
+            if ((e.events != 0) && (shard_of(e.key) == s.id)) {
+                candidates.emplace_back(e.events, i);
+            }
+        });
+        std::sort(candidates.begin(), candidates.end(), std::greater<>{});
+
+        uint64_t moved = 0;
+        for (const auto& c : candidates) {
+            if (moved + c.first > budget) {
+                continue;
+            }
+            moved += c.first;
+
+            auto& e = s.machines[c.second];
+            const auto key = e.key;
+            in_flight_.fetch_add(1, std::memory_order_relaxed);
+            send(s,
+                 to,
+                 transfer{key, event_type{}, std::make_unique<machine_type>(std::move(e.machine)),
+                          e.events});
+
+            s.index.erase(key);
+            s.machines.erase(c.second);
+            s.forwards.find_or_insert(key, [to] { return to; });
+            migrations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Apply a migration published by `rebalance` and start a new period for the event counts.
+    auto start_period(shard& s, bool stopping) -> void {
+        const auto to = s.migrate_to.exchange(no_shard, std::memory_order_relaxed);
+        if ((to != no_shard) && !stopping) {
+            migrate(s, to, s.migrate_budget.load(std::memory_order_relaxed));
+        }
+
+        s.machines.for_each([](slot_index, entry& e) { e.events = 0; });
+    }
+
+    // Process events until the executor is stopped. Once stopping, the shard reports when its
+    // producer queues are drained and keeps processing transfers until `stop` sees that no
+    // transfer is in flight.
+    auto run(shard& s) -> void {
+        while (running_.load(std::memory_order_acquire)) {
+            const auto stopping = stopping_.load(std::memory_order_acquire);
+
+            const auto epoch = epoch_.load(std::memory_order_acquire);
+            if (epoch != s.epoch) {
+                s.epoch = epoch;
+                start_period(s, stopping);
+            }
+
+            flush_pending(s);
+
+            size_t posted = 0;
+            for (auto& queue : s.queues) {
+                posted += queue->consume(batch_size, [this, &s](message& m) { receive(s, m); });
+            }
+
+            size_t transferred = 0;
+            for (auto& link : s.links) {
+                if (link) {
+                    transferred +=
+                        link->consume(batch_size, [this, &s](transfer& t) { receive(s, t); });
+                }
+            }
+
+            if (stopping && (posted == 0)) {
+                s.drained.store(true, std::memory_order_release);
+            }
+            if (posted + transferred == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    Hash hash_;
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<size_t> migrations_{0};
+    // The number of events processed by each shard at the previous call to `rebalance`.
+    std::vector<uint64_t> window_start_;
+};
+
+template <class Table, class Key, class Hash>
+constexpr size_t ShardedExecutor<Table, Key, Hash>::default_queue_capacity;
+
+template <class Table, class Key, class Hash>
+constexpr size_t ShardedExecutor<Table, Key, Hash>::batch_size;
+
+template <class Table, class Key, class Hash>
+constexpr size_t ShardedExecutor<Table, Key, Hash>::no_shard;
+
+} // namespace state_machine
+} // namespace state_machine
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace state_machine {
+namespace pool {
+
+namespace detail {
+
+// Keeps every slab allocated by a `slab_pool` reachable for the lifetime of the program. Slabs are
+// never released, as the slots of a slab may be cached by any thread.
+class slab_registry {
+  public:
+    static auto add(void* slab) -> void {
+        auto& self = instance();
+        const std::lock_guard<std::mutex> lock{self.mutex_};
+        self.slabs_.push_back(slab);
+    }
+
+  private:
+    static auto instance() -> slab_registry& {
+        // Intentionally leaked so that slabs outlive objects with static storage duration.
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        static auto* registry = new slab_registry{};
+        return *registry;
+    }
+
+    std::mutex mutex_;
+    std::vector<void*> slabs_;
+};
+
+} // namespace detail
+
+// A pool of fixed-size slots for objects of type `T`.
+//
+// Slots are carved out of slabs of `SlotsPerSlab` slots, which are allocated from the global heap
+// on demand and never released. Each thread allocates from and frees to a cache of its own, so
+// allocation and deallocation in steady state neither use the global heap nor take a lock.
+//
+// A slot may be freed on any thread. Once a thread caches `max_cached` free slots, it moves
+// `SlotsPerSlab` of them to a lock-free list shared by all threads, and a thread that exits moves
+// all of its cached slots there. A thread with an empty cache takes the whole shared list before
+// allocating a new slab, so slots allocated on one thread and freed on another are reused.
+template <class T, std::size_t SlotsPerSlab = 64>
+class slab_pool {
+    static_assert(SlotsPerSlab > 0, "A slab must contain at least one slot.");
+
+    union slot {
+        slot* next;
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    };
+
+    static_assert(alignof(slot) <= alignof(std::max_align_t),
+                  "`slab_pool` does not support over-aligned types.");
+
+  public:
+    static constexpr std::size_t slots_per_slab = SlotsPerSlab;
+
+    // The largest number of free slots kept by a thread.
+    static constexpr std::size_t max_cached = 2 * SlotsPerSlab;
+
+    // Allocate uninitialized storage for a `T`.
+    static auto allocate() -> void* {
+        auto& c = local();
+        if (c.head == nullptr) {
+            c.head = shared().exchange(nullptr, std::memory_order_acquire);
+            c.count = length(c.head);
+        }
+        if (c.head == nullptr) {
+            c.head = allocate_slab();
+            c.count = SlotsPerSlab;
+        }
+
+        auto* s = c.head;
+        c.head = s->next;
+        --c.count;
+
+        // A thread that has exited keeps no cache.
+        if (c.exited) {
+            flush(c);
+        }
+        return s;
+    }
+
+    // Return storage obtained from `allocate` to the pool. Any object in the storage must already
+    // have been destroyed.
+    static auto deallocate(void* p) noexcept -> void {
+        auto& c = local();
+        auto* s = new (p) slot{nullptr};
+
+        // Slots freed while the thread exits, after its cache was flushed, are shared directly.
+        if (c.exited) {
+            push_shared(s, s);
+            return;
+        }
+
+        s->next = c.head;
+        c.head = s;
+        if (++c.count >= max_cached) {
+            auto* last = c.head;
+            for (auto i = SlotsPerSlab; i > 1; --i) {
+                last = last->next;
+            }
+
+            auto* first = c.head;
+            c.head = last->next;
+            c.count -= SlotsPerSlab;
+            push_shared(first, last);
+        }
+    }
+
+  private:
+    // The free slots of a thread.
+    struct cache {
+        slot* head;
+        std::size_t count;
+        bool exited;
+    };
+
+    // Moves the free slots of a thread to the shared list when the thread exits.
+    class flusher {
+      public:
+        explicit flusher(cache& c) noexcept : c_{c} {}
+
+        flusher(const flusher&) = delete;
+        auto operator=(const flusher&) -> flusher& = delete;
+        flusher(flusher&&) = delete;
+        auto operator=(flusher&&) -> flusher& = delete;
+
+        ~flusher() {
+            c_.exited = true;
+            flush(c_);
+        }
+
+      private:
+        cache& c_;
+    };
+
+    // Move all slots of `c` to the shared list.
+    static auto flush(cache& c) noexcept -> void {
+        if (c.head != nullptr) {
+            auto* last = c.head;
+            while (last->next != nullptr) {
+                last = last->next;
+            }
+            push_shared(c.head, last);
+        }
+        c.head = nullptr;
+        c.count = 0;
+    }
+
+    // The cache is trivially destructible, so it stays usable by destructors of other
+    // `thread_local` objects running after `flusher`.
+    static auto local() noexcept -> cache& {
+        static thread_local cache c{nullptr, 0, false};
+        static thread_local const flusher f{c};
+        static_cast<void>(f);
+        return c;
+    }
+
+    static auto shared() noexcept -> std::atomic<slot*>& {
+        static std::atomic<slot*> head{nullptr};
+        return head;
+    }
+
+    // Push the chain of slots from `first` to `last` onto the shared list. Slots are only ever
+    // taken from the shared list all at once, so pushing is not subject to ABA.
+    static auto push_shared(slot* first, slot* last) noexcept -> void {
+        auto& head = shared();
+        auto* next = head.load(std::memory_order_relaxed);
+        do {
+            last->next = next;
+        } while (!head.compare_exchange_weak(
+            next, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    static auto length(const slot* s) noexcept -> std::size_t {
+        std::size_t n = 0;
+        for (; s != nullptr; s = s->next) {
+            ++n;
+        }
+        return n;
+    }
+
+    static auto allocate_slab() -> slot* {
+        auto* slab = static_cast<slot*>(::operator new(sizeof(slot) * SlotsPerSlab));
+        detail::slab_registry::add(slab);
+
+        slot* next = nullptr;
+        for (auto i = SlotsPerSlab; i > 0; --i) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            next = new (slab + (i - 1)) slot{next};
+        }
+        return next;
+    }
+};
+
+template <class T, std::size_t SlotsPerSlab>
+constexpr std::size_t slab_pool<T, SlotsPerSlab>::slots_per_slab;
+
+template <class T, std::size_t SlotsPerSlab>
+constexpr std::size_t slab_pool<T, SlotsPerSlab>::max_cached;
+
+} // namespace pool
+} // namespace state_machine
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace state_machine {
+namespace state_machine {
+
+namespace detail {
+
+// The size of a cache line, used to keep data written by different threads on separate lines.
+constexpr size_t cache_line_size = 64;
+
+// The smallest multiple of the cache line size that holds `size` bytes.
+constexpr auto cache_line_multiple(size_t size) noexcept -> size_t {
+    return (size + cache_line_size - 1) / cache_line_size * cache_line_size;
+}
+
+// A value padded to fill whole cache lines. Padding is used instead of `alignas` so that padded
+// objects may be allocated with `new` before C++17.
+template <class T>
+struct cache_padded {
+    T value;
+    char padding[cache_line_multiple(sizeof(T)) - sizeof(T) + cache_line_size];
+};
+
+// The smallest power of two not less than `n`, and at least 2.
+constexpr auto ceil_power_of_two(size_t n) noexcept -> size_t {
+    size_t p = 2;
+    while (p < n) {
+        p *= 2;
+    }
+    return p;
+}
+
+// A bounded lock-free queue for one producer thread and one consumer thread.
+//
+// The producer only writes the tail index and the consumer only writes the head index, each on its
+// own cache line. Each side keeps a cached copy of the other side's index, so the shared index is
+// only read when the cached copy suggests the queue is full or empty.
+template <class T>
+class spsc_ring {
+  public:
+    explicit spsc_ring(size_t capacity)
+        : mask_{ceil_power_of_two(capacity) - 1}, slots_{new slot[mask_ + 1]} {}
+
+    spsc_ring(const spsc_ring&) = delete;
+    auto operator=(const spsc_ring&) -> spsc_ring& = delete;
+    spsc_ring(spsc_ring&&) = delete;
+    auto operator=(spsc_ring&&) -> spsc_ring& = delete;
+
+    ~spsc_ring() {
+        consume(capacity(), [](T&) {});
+    }
+
+    auto capacity() const noexcept -> size_t { return mask_ + 1; }
+
+    // Append a `T` constructed from `args`, if the queue is not full. Called by the producer.
+    template <class... Args>
+    auto try_emplace(Args&&... args) -> bool {
+        auto& producer = producer_.value;
+        const auto tail = producer.tail.load(std::memory_order_relaxed);
+
+        if (tail - producer.cached_head > mask_) {
+            producer.cached_head = consumer_.value.head.load(std::memory_order_acquire);
+            if (tail - producer.cached_head > mask_) {
+                return false;
+            }
+        }
+
+        ::new (slots_[tail & mask_].address()) T(std::forward<Args>(args)...);
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Call `f(T&)` for up to `max_count` queued values in order, removing each after `f` returns.
+    // Returns the number of values consumed. Called by the consumer.
+    template <class F>
+    auto consume(size_t max_count, F&& f) -> size_t {
+        auto& consumer = consumer_.value;
+        const auto head = consumer.head.load(std::memory_order_relaxed);
+
+        if (consumer.cached_tail - head < max_count) {
+            consumer.cached_tail = producer_.value.tail.load(std::memory_order_acquire);
+        }
+
+        const auto available = consumer.cached_tail - head;
+        const auto count = (available < max_count) ? available : max_count;
+
+        for (size_t i = 0; i < count; ++i) {
+            // Release each slot as it is consumed, even if `f` throws, so the producer may reuse it
+            // while `f` runs for the next value.
+            const release r{consumer.head, slots_[(head + i) & mask_].get(), head + i + 1};
+            f(r.value);
+        }
+        return count;
+    }
+
+    // Check if the queue is empty. Exact only when called by the consumer with no producer running.
+    auto empty() const noexcept -> bool {
+        return consumer_.value.head.load(std::memory_order_acquire) ==
+               producer_.value.tail.load(std::memory_order_acquire);
+    }
+
+  private:
+    struct slot {
+        std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+
+        auto address() noexcept -> void* { return &storage; }
+        auto get() noexcept -> T& { return *static_cast<T*>(address()); }
+    };
+
+    // Destroys a consumed value and moves the head past its slot.
+    struct release {
+        std::atomic<size_t>& head;
+        T& value;
+        size_t next;
+
+        ~release() {
+            value.~T();
+            head.store(next, std::memory_order_release);
+        }
+    };
+
+    struct producer_state {
+        std::atomic<size_t> tail{0};
+        size_t cached_head = 0;
+    };
+
+    struct consumer_state {
+        std::atomic<size_t> head{0};
+        size_t cached_tail = 0;
+    };
+
+    // Read by both threads but never written after construction.
+    const size_t mask_;
+    std::unique_ptr<slot[]> slots_;
+    char padding_[cache_line_size] = {};
+
+    cache_padded<producer_state> producer_;
+    cache_padded<consumer_state> consumer_;
+};
+
+} // namespace detail
+
+} // namespace state_machine
+} // namespace state_machine
@@ -1,12 +1,18 @@
 #pragma once
 
 #include "state_machine/containers.h"
+#include "state_machine/error.h"
+#include "state_machine/pmr.h"
 #include "state_machine/traits.h"
 #include "state_machine/transition/transition_table.h"
 #include "state_machine/variant.h"
 
+#include <array>
 #include <cstdint>
+#include <cstring>
 #include <limits>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <tuple>
 #include <type_traits>
@@ -17,8 +23,16 @@ namespace state_machine {
 using ::state_machine::variant::Variant;
 namespace op = ::state_machine::containers::op;
 
-template <class Table>
-class StateMachine;
+// Names a Table with static storage duration, usually a `constexpr` table at namespace scope, as
+// the Table of a StateMachine. The machine then refers to `Instance` through its type instead of
+// storing the table or a reference to it, so it holds nothing but its current state:
+//
+//     constexpr auto table = make_transition_table(...);
+//     using Machine = StateMachine<static_table<decltype(table), table>>;
+template <class Table, const Table& Instance>
+struct static_table {
+    static constexpr auto get() noexcept -> const Table& { return Instance; }
+};
 
 namespace detail {
 
@@ -51,24 +65,702 @@ static auto on_exit(T& t) noexcept(noexcept(std::declval<T>().on_exit())) -> voi
     t.on_exit();
 }
 
+template <class Variant>
+struct any_has_on_exit;
+
+template <class Layout, class... Ts>
+struct any_has_on_exit<variant::BasicVariant<Layout, Ts...>>
+    : stdx::disjunction<has_on_exit<variant::unboxed_t<Ts>>...> {};
+
+// Holds the current state in one of two Variants. A new state is constructed in the inactive
+// Variant before the current state is destroyed, so a constructor that throws leaves the current
+// state in place. This doubles the storage used for states.
+template <class Variant>
+class double_buffered {
+  public:
+    constexpr auto index() const noexcept { return current().index(); }
+
+    template <class T>
+    constexpr auto holds() const noexcept -> bool {
+        return current().template holds<T>();
+    }
+
+    template <class T>
+    auto get() -> T& {
+        return current().template get<T>();
+    }
+
+    template <class T>
+    auto get() const -> const T& {
+        return current().template get<T>();
+    }
+
+    template <class Callable>
+    auto visit(Callable callable) {
+        return current().visit(callable);
+    }
+
+    template <class T>
+    auto set(T&& t) -> std::remove_reference_t<T>& {
+        auto& d = next().set(std::forward<T>(t));
+        flip();
+        return d;
+    }
+
+    template <class T, class... Args>
+    auto emplace(Args&&... args) -> T& {
+        auto& t = next().template emplace<T>(std::forward<Args>(args)...);
+        flip();
+        return t;
+    }
+
+    constexpr auto current() const noexcept -> const Variant& { return buffers_[active_]; }
+
+  private:
+    auto current() noexcept -> Variant& { return buffers_[active_]; }
+    auto next() noexcept -> Variant& { return buffers_[active_ ^ 1U]; }
+
+    // Destroy the current state and make the state constructed in `next()` current.
+    auto flip() -> void {
+        current().template emplace<variant::empty>();
+        active_ ^= 1U;
+    }
+
+    std::array<Variant, 2> buffers_{};
+    std::uint8_t active_ = 0;
+};
+
+template <class Variant>
+struct any_has_on_exit<double_buffered<Variant>> : any_has_on_exit<Variant> {};
+
+template <class Layout, class... Ts>
+constexpr auto current_variant(const variant::BasicVariant<Layout, Ts...>& v) noexcept
+    -> const variant::BasicVariant<Layout, Ts...>& {
+    return v;
+}
+
+template <class Variant>
+constexpr auto current_variant(const double_buffered<Variant>& v) noexcept -> const Variant& {
+    return v.current();
+}
+
+// Check if every alternative of a Variant can be set from a moved or copied value without throwing.
+// A Variant only becomes empty if setting or emplacing an alternative throws.
+template <class Variant>
+struct is_nothrow_settable;
+
+template <class Layout, class... Ts>
+struct is_nothrow_settable<variant::BasicVariant<Layout, Ts...>>
+    : stdx::conjunction<stdx::bool_constant<noexcept(
+          std::declval<variant::BasicVariant<Layout, Ts...>&>().set(
+              std::declval<variant::detail::move_or_copy_t<variant::unboxed_t<Ts>>>()))>...> {};
+
+template <class State, class BoxedList>
+using box_if_t =
+    std::conditional_t<op::contains<State, BoxedList>::value, variant::boxed<State>, State>;
+
+// Holds the current state and calls `on_exit` for it on destruction. If no state defines
+// `on_exit`, no destructor is declared so a StateMachine can remain trivially copyable and
+// trivially destructible.
+//
+// Moving leaves the moved-from state_variant empty, so `on_exit` is called once for a state that
+// is moved to another machine, by the machine holding it.
+template <class Variant, bool = any_has_on_exit<Variant>::value>
+class state_variant : public Variant {};
+
+template <class Variant>
+class state_variant<Variant, true> : public Variant {
+  public:
+    state_variant() = default;
+
+    state_variant(state_variant&& rhs) noexcept(std::is_nothrow_move_constructible<Variant>::value)
+        : Variant{std::move(rhs)} {
+        rhs.template emplace<variant::empty>();
+    }
+
+    // `on_exit` is called for the state replaced by the assignment.
+    auto operator=(state_variant&& rhs) noexcept(std::is_nothrow_move_assignable<Variant>::value)
+        -> state_variant& {
+        if (this != &rhs) {
+            exit();
+            Variant::operator=(std::move(rhs));
+            rhs.template emplace<variant::empty>();
+        }
+        return *this;
+    }
+
+    state_variant(const state_variant&) = delete;
+    auto operator=(const state_variant&) -> state_variant& = delete;
+
+    // Destructors of user-defined state types may throw
+    // NOLINTNEXTLINE(bugprone-exception-escape)
+    ~state_variant() { exit(); }
+
+  private:
+    auto exit() -> void {
+        if (this->index() != 0) {
+            this->visit([](auto&& s) { on_exit(std::forward<decltype(s)>(s)); });
+        }
+    }
+};
+
+// Holds the allocator of a StateMachine whose policy defines one. Move assignment takes the
+// allocator of the other machine along with its states, which were constructed with it, although a
+// `pmr::allocator` itself cannot be assigned.
+template <class Allocator>
+class allocator_holder {
+  public:
+    allocator_holder() = default;
+    explicit allocator_holder(const Allocator& alloc) noexcept : alloc_{alloc} {}
+
+    allocator_holder(const allocator_holder&) = default;
+    allocator_holder(allocator_holder&&) noexcept = default;
+
+    auto operator=(const allocator_holder&) -> allocator_holder& = delete;
+    auto operator=(allocator_holder&& rhs) noexcept -> allocator_holder& {
+        static_assert(std::is_nothrow_copy_constructible<Allocator>::value,
+                      "The allocator of a StateMachine must be nothrow copy constructible.");
+        if (this != &rhs) {
+            alloc_.~Allocator();
+            ::new (static_cast<void*>(&alloc_)) Allocator(rhs.alloc_);
+        }
+        return *this;
+    }
+
+    ~allocator_holder() = default;
+
+    auto allocator() const noexcept -> const Allocator& { return alloc_; }
+
+  private:
+    Allocator alloc_{};
+};
+
+template <>
+class allocator_holder<void> {};
+
+template <class Table>
+struct table_of {
+    using type = std::decay_t<Table>;
+};
+
+template <class Table, const Table& Instance>
+struct table_of<static_table<Table, Instance>> {
+    using type = std::decay_t<Table>;
+};
+
+template <class Table>
+struct is_static_table : std::false_type {};
+
+template <class Table, const Table& Instance>
+struct is_static_table<static_table<Table, Instance>> : std::true_type {};
+
+// Check if `Args...` is a single argument of type `Self`, so that a variadic constructor does not
+// take the place of a copy or move constructor.
+template <class Self, class... Args>
+struct is_self_arg : std::false_type {};
+
+template <class Self, class Arg>
+struct is_self_arg<Self, Arg> : std::is_same<std::decay_t<Arg>, Self> {};
+
+// Decode an event of type `Event` from the bytes at `payload`, which need not be aligned for
+// `Event`. The bytes are copied into a default constructed event, so `Event` must be default
+// constructible and trivially copyable.
+template <class Event>
+auto load_event(const void* payload) noexcept -> Event {
+    static_assert(std::is_trivially_copyable<Event>::value,
+                  "Events processed by index must be trivially copyable.");
+    static_assert(std::is_default_constructible<Event>::value,
+                  "Events processed by index must be default constructible.");
+
+    Event event;
+    std::memcpy(&event, payload, sizeof event);
+    return event;
+}
+
+// Check if `Args...` starts with `std::allocator_arg`, so that a variadic constructor does not take
+// the place of a constructor taking an allocator.
+template <class... Args>
+struct is_allocator_arg_first : std::false_type {};
+
+template <class Arg, class... Args>
+struct is_allocator_arg_first<Arg, Args...>
+    : std::is_same<std::decay_t<Arg>, std::allocator_arg_t> {};
+
+// Holds the Table of a StateMachine, either by value or by const reference. A `static_table` is
+// not stored.
+template <class Table>
+class table_holder {
+  public:
+    explicit table_holder(Table&& table) : table_{std::forward<Table>(table)} {}
+
+    auto table() const noexcept -> const std::decay_t<Table>& { return table_; }
+
+  private:
+    const Table table_;
+};
+
+template <class Table, const Table& Instance>
+class table_holder<static_table<Table, Instance>> {
+  public:
+    table_holder() = default;
+    explicit table_holder(const static_table<Table, Instance>&) noexcept {}
+
+    static auto table() noexcept -> const std::decay_t<Table>& { return Instance; }
+};
+
+struct construct_plain {};
+struct construct_leading {};
+struct construct_trailing {};
+
+// Selects how a state is constructed from `Args...` with uses-allocator construction: with
+// `std::allocator_arg` and the allocator leading the arguments, with the allocator trailing the
+// arguments, or without the allocator.
+template <class Allocator, class T, class... Args>
+struct uses_allocator_construction {
+    using type = std::conditional_t<
+        std::uses_allocator<T, Allocator>::value &&
+            std::is_constructible<T, std::allocator_arg_t, const Allocator&, Args...>::value,
+        construct_leading,
+        std::conditional_t<std::uses_allocator<T, Allocator>::value &&
+                               std::is_constructible<T, Args..., const Allocator&>::value,
+                           construct_trailing,
+                           construct_plain>>;
+};
+
+template <class T, class... Args>
+struct uses_allocator_construction<void, T, Args...> {
+    using type = construct_plain;
+};
+
+template <class Transition, class Event, class Allocator, class = void>
+struct action_accepts_allocator : std::false_type {};
+
+template <class Transition, class Event, class Allocator>
+struct action_accepts_allocator<
+    Transition,
+    Event,
+    Allocator,
+    stdx::void_t<decltype(std::declval<const Transition&>().invoke_action(
+        std::declval<typename Transition::source_type&>(),
+        std::declval<Event>(),
+        std::declval<const Allocator&>()))>> : std::true_type {};
+
+// Check if the action of every transition in the rows of a Table can be invoked by a StateMachine
+// whose policy has `Allocator`.
+template <class Transitions, class Allocator>
+struct are_actions_for;
+
+template <class... Transitions, class Allocator>
+struct are_actions_for<std::tuple<Transitions...>, Allocator>
+    : stdx::conjunction<typename Transitions::template is_action_for<Allocator>...> {};
+
+template <class Rows, class Allocator>
+struct are_table_actions_for;
+
+template <class... Rows, class Allocator>
+struct are_table_actions_for<std::tuple<Rows...>, Allocator>
+    : stdx::conjunction<are_actions_for<typename Rows::data_type, Allocator>...> {};
+
+// Holds states of the types `Recycled...` after a StateMachine leaves them, so their resources,
+// such as the capacity of buffers, can be reused the next time the machine enters that state.
+template <class Recycled>
+class state_cache;
+
+template <class... Recycled>
+class state_cache<containers::list<Recycled...>> {
+    template <class State>
+    using enable_if_recycled_t =
+        std::enable_if_t<op::contains<State, containers::list<Recycled...>>::value, int>;
+
+  public:
+    template <class State, enable_if_recycled_t<State> = 0>
+    auto park(State& s) noexcept(
+        noexcept(std::declval<Variant<State>&>().set(std::declval<State&&>()))) -> void {
+        std::get<Variant<State>>(slots_).set(std::move(s));
+    }
+
+    template <class State,
+              std::enable_if_t<!op::contains<State, containers::list<Recycled...>>::value, int> = 0>
+    auto park(State&) noexcept -> void {}
+
+    template <class State, enable_if_recycled_t<State> = 0>
+    auto is_parked() const noexcept -> bool {
+        return std::get<Variant<State>>(slots_).template holds<State>();
+    }
+
+    template <class State, enable_if_recycled_t<State> = 0>
+    auto take() -> State {
+        return std::get<Variant<State>>(slots_).template take<State>();
+    }
+
+  private:
+    std::tuple<Variant<Recycled>...> slots_;
+};
+
+// No storage is used if no states are recycled.
+template <>
+class state_cache<containers::list<>> {
+  public:
+    template <class State>
+    auto park(State&) noexcept -> void {}
+};
+
+// Check if the state constructed by `InPlace`, an `in_place_construct`, can instead be reset from
+// the same arguments with a `reset` member function.
+template <class InPlace, class = void>
+struct is_resettable_from : std::false_type {};
+
+template <class T, class... Args>
+struct is_resettable_from<
+    transition::in_place_construct<T, Args...>,
+    stdx::void_t<decltype(std::declval<T&>().reset(std::declval<Args>()...))>>
+    : std::true_type {};
+
+// Check if `Destination`, the result of an action, can be reset from a state in `RecycledList`.
+template <class Destination, class RecycledList, class = void>
+struct is_recycled_destination : std::false_type {};
+
+template <class Destination, class RecycledList>
+struct is_recycled_destination<
+    Destination,
+    RecycledList,
+    std::enable_if_t<transition::is_in_place_construct<Destination>::value>>
+    : stdx::conjunction<op::contains<typename Destination::type, RecycledList>,
+                        is_resettable_from<Destination>> {};
+
+struct not_invocable {};
+
+// The result of invoking the action of `Transition` with `Args...` following the source state, or
+// `not_invocable`, also for a const event that the action takes as `Event&`.
+template <class Transition, class ArgList, class = void>
+struct action_result {
+    using type = not_invocable;
+};
+
+template <class Transition, class... Args>
+struct action_result<Transition,
+                     containers::list<Args...>,
+                     stdx::void_t<decltype(std::declval<const Transition&>().invoke_action(
+                         std::declval<typename Transition::source_type&>(),
+                         std::declval<Args>()...))>> {
+    using result_type = decltype(std::declval<const Transition&>().invoke_action(
+        std::declval<typename Transition::source_type&>(), std::declval<Args>()...));
+    using type = std::conditional_t<
+        std::is_same<result_type, transition::detail::const_event_result>::value,
+        not_invocable,
+        result_type>;
+};
+
+// The arguments following the source state that a StateMachine passes to the action of
+// `Transition` for an event argument of type `Event`.
+template <class Transition, class Event, class Allocator>
+using machine_action_args =
+    std::conditional_t<action_accepts_allocator<Transition, Event, Allocator>::value,
+                       containers::list<Event, std::add_lvalue_reference_t<const Allocator>>,
+                       containers::list<Event>>;
+
+// The result of the action of `Transition` as invoked by a StateMachine, for an event passed as an
+// rvalue, an lvalue or a const lvalue, whichever the action accepts first.
+template <class Transition, class Allocator>
+struct transition_result {
+    template <class Event>
+    using result_for =
+        typename action_result<Transition,
+                               machine_action_args<Transition, Event, Allocator>>::type;
+
+    using event_type = typename Transition::event_type;
+    using rvalue = result_for<event_type&&>;
+    using lvalue = result_for<event_type&>;
+    using const_lvalue = result_for<const event_type&>;
+
+    using type = std::conditional_t<
+        !std::is_same<rvalue, not_invocable>::value,
+        rvalue,
+        std::conditional_t<!std::is_same<lvalue, not_invocable>::value, lvalue, const_lvalue>>;
+};
+
+template <class Variant, class Construction, class Allocator, class State, class... Args>
+struct is_nothrow_emplace_with;
+
+template <class Variant, class Allocator, class State, class... Args>
+struct is_nothrow_emplace_with<Variant, construct_plain, Allocator, State, Args...>
+    : stdx::bool_constant<noexcept(
+          std::declval<Variant&>().template emplace<State>(std::declval<Args>()...))> {};
+
+template <class Variant, class Allocator, class State, class... Args>
+struct is_nothrow_emplace_with<Variant, construct_leading, Allocator, State, Args...>
+    : stdx::bool_constant<noexcept(std::declval<Variant&>().template emplace<State>(
+          std::allocator_arg, std::declval<const Allocator&>(), std::declval<Args>()...))> {};
+
+template <class Variant, class Allocator, class State, class... Args>
+struct is_nothrow_emplace_with<Variant, construct_trailing, Allocator, State, Args...>
+    : stdx::bool_constant<noexcept(std::declval<Variant&>().template emplace<State>(
+          std::declval<Args>()..., std::declval<const Allocator&>()))> {};
+
+// Check if storing the result of an action in a StateMachine cannot throw once the source state
+// has been destroyed. States returned by value are covered by `is_nothrow_settable`. A result that
+// cannot be determined is assumed to throw.
+template <class Result, class Variant, class Allocator>
+struct is_nothrow_result : std::true_type {};
+
+template <class Variant, class Allocator>
+struct is_nothrow_result<not_invocable, Variant, Allocator> : std::false_type {};
+
+template <class State, class... Args, class Variant, class Allocator>
+struct is_nothrow_result<transition::in_place_construct<State, Args...>, Variant, Allocator>
+    : is_nothrow_emplace_with<
+          Variant,
+          typename uses_allocator_construction<Allocator, State, Args...>::type,
+          Allocator,
+          State,
+          Args...> {};
+
+template <class Transitions, class Variant, class Allocator>
+struct is_nothrow_row;
+
+template <class... Transitions, class Variant, class Allocator>
+struct is_nothrow_row<std::tuple<Transitions...>, Variant, Allocator>
+    : stdx::conjunction<is_nothrow_result<typename transition_result<Transitions, Allocator>::type,
+                                          Variant,
+                                          Allocator>...> {};
+
+// Check if no action in the rows of a Table can leave a StateMachine empty.
+template <class Rows, class Variant, class Allocator>
+struct is_nothrow_table;
+
+template <class... Rows, class Variant, class Allocator>
+struct is_nothrow_table<std::tuple<Rows...>, Variant, Allocator>
+    : stdx::conjunction<is_nothrow_row<typename Rows::data_type, Variant, Allocator>...> {};
+
+template <class Transition, class ArgList, class = void>
+struct is_nothrow_action : std::false_type {};
+
+template <class Transition, class... Args>
+struct is_nothrow_action<Transition,
+                         containers::list<Args...>,
+                         stdx::void_t<decltype(std::declval<const Transition&>().invoke_action(
+                             std::declval<typename Transition::source_type&>(),
+                             std::declval<Args>()...))>>
+    : stdx::bool_constant<noexcept(std::declval<const Transition&>().invoke_action(
+          std::declval<typename Transition::source_type&>(), std::declval<Args>()...))> {};
+
+template <class InPlace>
+struct is_nothrow_resettable_from;
+
+template <class T, class... Args>
+struct is_nothrow_resettable_from<transition::in_place_construct<T, Args...>>
+    : stdx::bool_constant<noexcept(std::declval<T&>().reset(std::declval<Args>()...))> {};
+
+// Check if storing `Result`, the result of an action, as the current state of a StateMachine with
+// `Policy` cannot throw. The result of an internal transition is discarded and a source state
+// returned by reference is kept.
+template <class Result, bool Self, class Variant, class Policy, class = void>
+struct is_nothrow_store : std::true_type {};
+
+template <bool Self, class Variant, class Policy>
+struct is_nothrow_store<not_invocable, Self, Variant, Policy> : std::false_type {};
+
+template <class Result, bool Self, class Variant, class Policy>
+struct is_nothrow_store<Result,
+                        Self,
+                        Variant,
+                        Policy,
+                        std::enable_if_t<!std::is_reference<Result>::value &&
+                                         !std::is_void<Result>::value &&
+                                         !transition::is_in_place_construct<Result>::value>>
+    : stdx::conjunction<
+          stdx::bool_constant<noexcept(std::declval<Variant&>().set(std::declval<Result>()))>,
+          stdx::disjunction<stdx::bool_constant<!Self>,
+                            std::is_nothrow_move_assignable<Result>>> {};
+
+template <class Result, bool Self, class Variant, class Policy>
+struct is_nothrow_store<Result,
+                        Self,
+                        Variant,
+                        Policy,
+                        std::enable_if_t<transition::is_in_place_construct<Result>::value>>
+    : stdx::conjunction<
+          is_nothrow_result<Result, Variant, typename Policy::allocator_type>,
+          stdx::disjunction<
+              stdx::negation<is_recycled_destination<Result, typename Policy::recycled_types>>,
+              stdx::conjunction<
+                  is_nothrow_resettable_from<Result>,
+                  stdx::bool_constant<noexcept(std::declval<Variant&>().set(
+                      std::declval<typename Result::type>()))>>>> {};
+
+// Check if leaving the source state and entering the destination state of `Transition` cannot
+// throw.
+template <class Transition, class Policy, bool = Transition::internal>
+struct is_nothrow_exit_entry : std::true_type {};
+
+template <class Transition, class Policy>
+struct is_nothrow_exit_entry<Transition, Policy, false>
+    : stdx::bool_constant<
+          noexcept(on_exit(std::declval<typename Transition::source_type&>())) &&
+          noexcept(on_entry(std::declval<typename Transition::destination_type&>())) &&
+          noexcept(std::declval<state_cache<typename Policy::recycled_types>&>().park(
+              std::declval<typename Transition::source_type&>()))> {};
+
+// Check if a StateMachine with `Policy` can perform `Transition` for an event argument of type
+// `Event` without throwing.
+template <class Transition, class Event, class Variant, class Policy>
+struct is_nothrow_transition
+    : stdx::conjunction<
+          transition::is_nothrow_guard_invocable<Transition>,
+          is_nothrow_action<
+              Transition,
+              machine_action_args<Transition, Event, typename Policy::allocator_type>>,
+          is_nothrow_exit_entry<Transition, Policy>,
+          is_nothrow_store<
+              typename action_result<
+                  Transition,
+                  machine_action_args<Transition, Event, typename Policy::allocator_type>>::type,
+              Transition::self,
+              Variant,
+              Policy>> {};
+
+template <class Transitions, class Event, class Variant, class Policy>
+struct is_nothrow_transitions;
+
+template <class... Transitions, class Event, class Variant, class Policy>
+struct is_nothrow_transitions<std::tuple<Transitions...>, Event, Variant, Policy>
+    : stdx::conjunction<is_nothrow_transition<Transitions, Event, Variant, Policy>...> {};
+
+template <class Row,
+          class Event,
+          class Variant,
+          class Policy,
+          bool = std::is_same<typename Row::event_type, std::decay_t<Event>>::value>
+struct is_nothrow_event_row : std::true_type {};
+
+template <class Row, class Event, class Variant, class Policy>
+struct is_nothrow_event_row<Row, Event, Variant, Policy, true>
+    : is_nothrow_transitions<typename Row::data_type, Event, Variant, Policy> {};
+
+// Check if every transition in the rows of a Table for an event argument of type `Event` can be
+// performed without throwing.
+template <class Rows, class Event, class Variant, class Policy>
+struct is_nothrow_event;
+
+template <class... Rows, class Event, class Variant, class Policy>
+struct is_nothrow_event<std::tuple<Rows...>, Event, Variant, Policy>
+    : stdx::conjunction<is_nothrow_event_row<Rows, Event, Variant, Policy>...> {};
+
 } // namespace detail
 
+// The default policy of a StateMachine. A policy customizes the representation of a StateMachine.
+// Other policies may derive from this type and replace only the members that differ.
+struct default_policy {
+    // The Variant template used to hold the current state.
+    template <class... States>
+    using variant_template = Variant<States...>;
+
+    // The allocator used to construct states, or `void` if states are constructed without one.
+    using allocator_type = void;
+
+    // The states kept for reuse after the machine leaves them.
+    using recycled_types = containers::list<>;
+
+    // Set to hold the current state in one of two Variants. See `double_buffer_policy`.
+    static constexpr bool double_buffered = false;
+
+    // Set to return `process_status::InvalidState` from `process_event` for a machine without a
+    // current state instead of raising `bad_state_access`. See `status_policy`.
+    static constexpr bool invalid_state_status = false;
+};
+
+// A policy that stores the index of the current state in the state storage where the size and
+// alignment of the states allow. See `variant::index_packing`.
+struct packed_policy : default_policy {
+    template <class... States>
+    using variant_template = variant::PackedVariant<States...>;
+};
+
+// A policy that stores the states `Boxed...` out of line, in slots of a `pool::slab_pool`, so the
+// size of a StateMachine is determined by the remaining states. Slots are recycled through the
+// pool as the machine transitions in and out of a boxed state. A machine may move between threads:
+// slots freed on a thread other than the one that allocated them are returned to all threads
+// through the shared list of the pool.
+template <class... Boxed>
+struct boxed_policy : default_policy {
+    template <class... States>
+    using variant_template = Variant<detail::box_if_t<States, containers::list<Boxed...>>...>;
+};
+
+// A policy that gives a StateMachine a `pmr::allocator`. States that use an allocator are
+// constructed with uses-allocator construction, and actions may take the allocator as a last
+// argument, so buffers owned by states and built by actions come from one memory resource, for
+// example a `pmr::monotonic_buffer_resource` per machine or per batch of machines.
+template <class Base = default_policy>
+struct pmr_policy : Base {
+    using allocator_type = pmr::allocator;
+};
+
+// A policy that recycles the states `Recycled...`. When the machine leaves one of these states, the
+// state object is moved into a cache held by the machine instead of being destroyed. An action
+// returning `emplace<State>(args...)` for a recycled state then has the cached object reset with
+// `State::reset(args...)` and moved back into the machine, so the buffers of the state keep their
+// capacity and a machine cycling through its states does not allocate in steady state. A recycled
+// state without a matching `reset` is constructed as usual.
+template <class... Recycled>
+struct recycling_policy : default_policy {
+    using recycled_types = containers::list<Recycled...>;
+};
+
+// A policy that constructs each new state alongside the current state and destroys the current
+// state only once construction succeeds. A transition that throws while constructing the
+// destination leaves the machine in the source state, even if moving states may throw, so
+// `process_event` never has to check for an empty state. The machine holds storage for two
+// states.
+struct double_buffer_policy : default_policy {
+    static constexpr bool double_buffered = true;
+};
+
+// A policy that reports a machine without a current state with a `process_status` instead of an
+// error, so `process_event` does not throw or call the error handler for it. Together with a table
+// whose guards, actions and states do not throw, `process_event` is then `noexcept`.
+template <class Base = default_policy>
+struct status_policy : Base {
+    static constexpr bool invalid_state_status = true;
+};
+
+template <class Table, class Policy = default_policy>
+class StateMachine;
+
 template <class Table, class... Args>
 constexpr auto make_state_machine(Table&& table, Args&&... args) -> StateMachine<Table> {
     return StateMachine<Table>{std::forward<Table>(table), std::forward<Args>(args)...};
 }
 
-// The type of exception thrown if `StateMachine::process_event` is called with an invalid internal
-// state.
+// The error raised if `StateMachine::process_event` is called with an invalid internal state.
 class bad_state_access : public std::exception {};
 
 // The return type for `StateMachine::process_event`.
-enum process_status : uint8_t { Completed, EventIgnored, GuardFailure, UndefinedTransition };
+enum process_status : uint8_t {
+    Completed,
+    EventIgnored,
+    GuardFailure,
+    UndefinedTransition,
+    InvalidState
+};
+
+template <class Table, class Policy>
+class StateMachine : private detail::table_holder<Table>,
+                     private detail::allocator_holder<typename Policy::allocator_type>,
+                     private detail::state_cache<typename Policy::recycled_types> {
+    using table_base = detail::table_holder<Table>;
+    using allocator_base = detail::allocator_holder<typename Policy::allocator_type>;
+    using cache_base = detail::state_cache<typename Policy::recycled_types>;
+
+    template <class... Args>
+    using is_static_construction =
+        stdx::conjunction<detail::is_static_table<Table>,
+                          stdx::negation<detail::is_self_arg<StateMachine, Args...>>>;
 
-template <class Table>
-class StateMachine {
   public:
-    static_assert(transition::is_table<std::decay_t<Table>>::value,
+    using table_type = typename detail::table_of<Table>::type;
+
+    static_assert(transition::is_table<table_type>::value,
                   "A `StateMachine` must be created from a `Table`");
 
     static_assert(std::conditional_t<std::is_lvalue_reference<Table>::value,
@@ -76,18 +768,61 @@ class StateMachine {
                                      std::true_type>::value,
                   "When using a Table reference, that Table must be const.");
 
-    using type = StateMachine<Table>;
-    using state_types = typename std::decay_t<Table>::state_types;
-    using event_types = typename std::decay_t<Table>::event_types;
+    using type = StateMachine<Table, Policy>;
+    using state_types = typename table_type::state_types;
+    using event_types = typename table_type::event_types;
     using initial_state_type =
-        typename std::tuple_element_t<0, typename std::decay_t<Table>::data_type>::source_type;
+        typename std::tuple_element_t<0, typename table_type::data_type>::source_type;
+
+    using variant_type = op::repack<state_types, Policy::template variant_template>;
+    using allocator_type = typename Policy::allocator_type;
 
-    using variant_type = op::repack<state_types, Variant>;
+    static_assert(detail::are_table_actions_for<typename table_type::data_type,
+                                                allocator_type>::value,
+                  "An action takes an allocator of a type other than the `allocator_type` of the "
+                  "policy.");
+
+    // Set if a transition cannot leave the machine without a state, so `process_event` does not
+    // check for one. This holds with `double_buffer_policy`, or if every state can be moved into
+    // the machine and every state constructed in place by an action can be constructed without
+    // throwing. Only a moved-from machine may then be empty, which `process_event` reports as an
+    // `UndefinedTransition`.
+    static constexpr bool never_empty =
+        Policy::double_buffered ||
+        (detail::is_nothrow_settable<variant_type>::value &&
+         detail::is_nothrow_table<typename table_type::data_type,
+                                  variant_type,
+                                  allocator_type>::value);
 
     template <class... Args>
-    explicit StateMachine(Table&& table, Args&&... args) : table_{std::forward<Table>(table)} {
-        state_.template emplace<initial_state_type>(std::forward<Args>(args)...);
-        state_.visit([](auto&& s) { detail::on_entry(std::forward<decltype(s)>(s)); });
+    explicit StateMachine(Table&& table, Args&&... args) : table_base{std::forward<Table>(table)} {
+        enter_initial_state(std::forward<Args>(args)...);
+    }
+
+    // Create a StateMachine using `alloc` to construct states and pass to actions.
+    template <class... Args,
+              class A = allocator_type,
+              std::enable_if_t<!std::is_void<A>::value, int> = 0>
+    StateMachine(std::allocator_arg_t, const A& alloc, Table&& table, Args&&... args)
+        : table_base{std::forward<Table>(table)}, allocator_base{alloc} {
+        enter_initial_state(std::forward<Args>(args)...);
+    }
+
+    // Create a StateMachine for a `static_table`, constructing the initial state from `args`.
+    template <class... Args,
+              std::enable_if_t<is_static_construction<Args...>::value &&
+                                   !detail::is_allocator_arg_first<Args...>::value,
+                               int> = 0>
+    explicit StateMachine(Args&&... args) {
+        enter_initial_state(std::forward<Args>(args)...);
+    }
+
+    template <class... Args,
+              class A = allocator_type,
+              std::enable_if_t<!std::is_void<A>::value && is_static_construction<Args...>::value,
+                               int> = 0>
+    StateMachine(std::allocator_arg_t, const A& alloc, Args&&... args) : allocator_base{alloc} {
+        enter_initial_state(std::forward<Args>(args)...);
     }
 
     StateMachine(StateMachine&&) noexcept(std::is_nothrow_move_constructible<variant_type>::value) =
@@ -98,23 +833,58 @@ class StateMachine {
     StateMachine(const StateMachine&) = delete;
     auto operator=(const StateMachine&) -> StateMachine& = delete;
 
-    // Destructors of user-defined state types may throw
-    // NOLINTNEXTLINE(bugprone-exception-escape)
-    ~StateMachine() {
-        state_.visit([](auto&& s) { detail::on_exit(std::forward<decltype(s)>(s)); });
-    }
+    // `on_exit` is called for the current state by `state_` on destruction. A StateMachine is
+    // trivially copyable and trivially destructible if the table and all states are and no state
+    // defines `on_exit`.
+    ~StateMachine() = default;
 
-    template <class Event, std::enable_if_t<op::contains<Event, event_types>::value, int> = 0>
-    auto process_event(Event&& event) -> process_status {
+    // Check if `process_event` cannot throw for an event argument of type `Event`. This holds if
+    // the machine cannot be without a state or reports that with a `process_status`, and the
+    // guards, actions, states and entry and exit actions of every transition for the event do
+    // not throw.
+    template <class Event>
+    using is_nothrow_event = stdx::conjunction<
+        stdx::bool_constant<never_empty || Policy::invalid_state_status>,
+        detail::is_nothrow_event<typename table_type::data_type,
+                                 Event,
+                                 variant_type,
+                                 Policy>>;
+
+    // Events may be passed as lvalues, const lvalues, or rvalues without being copied. Rvalue
+    // events are passed to actions as rvalues, allowing actions to move from them.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    auto process_event(Event&& event) noexcept(is_nothrow_event<Event&&>::value)
+        -> process_status {
         static_assert(variant_type::template alternative_index<variant::empty>() == 0, "");
 
-        if (state_.index() == 0) {
-            throw bad_state_access{};
+        if (!never_empty && (state_.index() == 0)) {
+            if (Policy::invalid_state_status) {
+                return process_status::InvalidState;
+            }
+            error::raise(bad_state_access{});
         }
 
-        // Skip the first "empty" index when searching for the transition row.
-        return find_row(std::forward<Event>(event),
-                        aux::make_index_range<1, 1 + variant_type::size>{});
+        return dispatch(std::forward<Event>(event),
+                        std::make_index_sequence<1 + variant_type::size>{});
+    }
+
+    // Process an event identified by its index in `event_types`, where `payload` points to the
+    // bytes of an object of that event type, such as a message in a receive buffer. The bytes
+    // need not be aligned and are copied into an event passed as an rvalue, so every event type
+    // must be default constructible and trivially copyable. This allows events received as a tag
+    // and payload to be dispatched without a `switch` over all event types. An out of range
+    // `event_index` is reported as an `UndefinedTransition`.
+    auto process_event_id(size_t event_index, const void* payload) -> process_status {
+        return dispatch_event_id(
+            event_index, payload, std::make_index_sequence<op::size<event_types>::value>{});
+    }
+
+    // The index of `Event` in `event_types`, for use with `process_event_id`.
+    template <class Event,
+              std::enable_if_t<op::contains<std::decay_t<Event>, event_types>::value, int> = 0>
+    static constexpr auto event_index() noexcept -> size_t {
+        return table_type::event_index_map::template at_key<std::decay_t<Event>>::value;
     }
 
     template <class State, std::enable_if_t<op::contains<State, state_types>::value, int> = 0>
@@ -122,40 +892,87 @@ class StateMachine {
         return state_.template holds<State>();
     }
 
+    // The Variant holding the current state. Multiple machines may be inspected together with
+    // `variant::visit(callable, sm1.current_state(), sm2.current_state())`.
+    constexpr auto current_state() const noexcept -> const variant_type& {
+        return detail::current_variant(state_);
+    }
+
+    template <class A = allocator_type, std::enable_if_t<!std::is_void<A>::value, int> = 0>
+    auto get_allocator() const noexcept -> A {
+        return this->allocator();
+    }
+
   private:
-    struct transition_not_found {};
+    using row_index_type = typename table_type::row_index_type;
+
+    using state_storage_type = std::conditional_t<Policy::double_buffered,
+                                                  detail::double_buffered<variant_type>,
+                                                  variant_type>;
+
+    template <class Destination>
+    using is_recycled_destination =
+        detail::is_recycled_destination<std::decay_t<Destination>, typename Policy::recycled_types>;
 
     template <class Event>
-    constexpr auto find_row(Event&&, std::index_sequence<>) -> process_status {
-        return process_status::UndefinedTransition;
+    using handler_type = process_status (*)(StateMachine&, Event&&);
+
+    // Jump to the handler for the current state with a table indexed by `Variant::index()`. The
+    // cost of dispatch does not depend on the position of the state in `state_types`.
+    template <class Event, size_t... Is>
+    auto dispatch(Event&& event, std::index_sequence<Is...>) -> process_status {
+        static constexpr handler_type<Event> handlers[] = {&type::handle_state<Event, Is>...};
+
+        return handlers[state_.index()](*this, std::forward<Event>(event));
     }
 
-    template <class Event, size_t I, size_t... Is>
-    constexpr auto find_row(Event&& event, std::index_sequence<I, Is...>) -> process_status {
-        using state_type =
-            typename variant_type::alternative_index_map::template at_value<aux::index_constant<I>>;
+    using event_id_handler_type = process_status (*)(StateMachine&, const void*);
 
-        using key_type = transition::Key<transition::State<state_type>, transition::Event<Event>>;
+    template <size_t... Is>
+    auto dispatch_event_id(size_t event_index, const void* payload, std::index_sequence<Is...>)
+        -> process_status {
+        static constexpr event_id_handler_type handlers[] = {&type::handle_event_id<Is>...};
+
+        if (event_index >= sizeof...(Is)) {
+            return process_status::UndefinedTransition;
+        }
 
-        return (state_.index() == I) ?
-                   get_row_transitions(std::forward<Event>(event),
-                                       typename std::decay_t<Table>::row_index_map::
-                                           template at_key<key_type, transition_not_found>{}) :
-                   find_row(std::forward<Event>(event), std::index_sequence<Is...>{});
+        return handlers[event_index](*this, payload);
     }
 
-    template <class Event>
-    auto get_row_transitions(Event&&, transition_not_found) -> process_status {
+    template <size_t I>
+    static auto handle_event_id(StateMachine& self, const void* payload) -> process_status {
+        using event_type =
+            typename table_type::event_index_map::template at_value<aux::index_constant<I>>;
+
+        return self.process_event(detail::load_event<event_type>(payload));
+    }
+
+    // The handler for index 0 ("empty") is never called as `process_event` checks for an empty
+    // state, but it is still generated to keep the table indexable by `Variant::index()`.
+    template <class Event, size_t I>
+    static auto handle_state(StateMachine& self, Event&& event) -> process_status {
+        constexpr auto event_index =
+            table_type::event_index_map::template at_key<std::decay_t<Event>>::value;
+        constexpr auto row_index =
+            (I == 0) ? table_type::undefined_row : table_type::row_index(I - 1, event_index);
+
+        return self.get_row_transitions(std::forward<Event>(event),
+                                        std::integral_constant<row_index_type, row_index>{});
+    }
+
+    template <class Event,
+              class RowIndexConstant,
+              std::enable_if_t<RowIndexConstant::value == table_type::undefined_row, int> = 0>
+    auto get_row_transitions(Event&&, RowIndexConstant) -> process_status {
         return process_status::UndefinedTransition;
     }
 
     template <class Event,
               class RowIndexConstant,
-              std::enable_if_t<std::is_same<aux::index_constant<RowIndexConstant::value>,
-                                            RowIndexConstant>::value,
-                               int> = 0>
+              std::enable_if_t<RowIndexConstant::value != table_type::undefined_row, int> = 0>
     auto get_row_transitions(Event&& event, RowIndexConstant) -> process_status {
-        const auto& row = std::get<RowIndexConstant::value>(table_.data());
+        const auto& row = std::get<RowIndexConstant::value>(this->table().data());
 
         return find_transition(row,
                                std::forward<Event>(event),
@@ -189,28 +1006,185 @@ class StateMachine {
 
         auto& s = state_.template get<typename Transition::source_type>();
 
-        transition.invoke_action(s, event);
+        invoke_action(transition, s, std::forward<Event>(event));
 
         return process_status::Completed;
     }
 
+    // Perform an external self-transition marked `reuse`, reusing the source state object
+    template <class Transition, class Event, std::enable_if_t<Transition::self, int> = 0>
+    auto do_transition(const Transition& transition, Event&& event) -> process_status {
+        auto& s = state_.template get<typename Transition::source_type>();
+
+        detail::on_exit(s);
+
+        auto& d = reuse_destination(s, invoke_action(transition, s, std::forward<Event>(event)));
+
+        detail::on_entry(d);
+
+        return process_status::Completed;
+    }
+
+    // The action mutated the source state and returned it.
+    template <class State>
+    auto reuse_destination(State& s, State&) -> State& {
+        return s;
+    }
+
+    template <
+        class State,
+        class Destination,
+        std::enable_if_t<!transition::is_in_place_construct<Destination>::value &&
+                             !std::is_lvalue_reference<Destination>::value &&
+                             std::is_move_assignable<std::remove_reference_t<Destination>>::value,
+                         int> = 0>
+    auto reuse_destination(State& s, Destination&& destination) -> State& {
+        s = std::forward<Destination>(destination);
+        return s;
+    }
+
+    // Reset a recycled state from the arguments it would be constructed from.
+    template <class State,
+              class Destination,
+              std::enable_if_t<is_recycled_destination<Destination>::value, int> = 0>
+    auto reuse_destination(State& s, Destination&& destination) -> State& {
+        std::move(destination).apply(
+            [&s](auto&&... args) { s.reset(std::forward<decltype(args)>(args)...); });
+        return s;
+    }
+
+    // Fall back to destroying and constructing the state if it cannot be assigned.
+    template <class State,
+              class Destination,
+              std::enable_if_t<
+                  (transition::is_in_place_construct<Destination>::value &&
+                   !is_recycled_destination<Destination>::value) ||
+                      (!std::is_lvalue_reference<Destination>::value &&
+                       !std::is_move_assignable<std::remove_reference_t<Destination>>::value),
+                  int> = 0>
+    auto reuse_destination(State&, Destination&& destination) -> State& {
+        return set_destination(std::forward<Destination>(destination));
+    }
+
     // Perform an external transition
-    template <class Transition, class Event, std::enable_if_t<!Transition::internal, int> = 0>
+    template <class Transition,
+              class Event,
+              std::enable_if_t<!Transition::internal && !Transition::self, int> = 0>
     auto do_transition(const Transition& transition, Event&& event) -> process_status {
         auto& s = state_.template get<typename Transition::source_type>();
 
         detail::on_exit(s);
 
-        auto& d = state_.set(transition.invoke_action(s, event));
+        auto&& destination = invoke_action(transition, s, std::forward<Event>(event));
+
+        this->park(s);
+
+        auto& d = set_destination(std::forward<decltype(destination)>(destination));
 
         detail::on_entry(d);
 
         return process_status::Completed;
     }
 
-    const Table table_;
-    variant_type state_;
+    // Pass the allocator to actions that accept it.
+    template <class Transition,
+              class Event,
+              std::enable_if_t<
+                  detail::action_accepts_allocator<Transition, Event, allocator_type>::value,
+                  int> = 0>
+    auto invoke_action(const Transition& transition,
+                       typename Transition::source_type& s,
+                       Event&& event) -> decltype(auto) {
+        return transition.invoke_action(s, std::forward<Event>(event), this->allocator());
+    }
+
+    template <class Transition,
+              class Event,
+              std::enable_if_t<
+                  !detail::action_accepts_allocator<Transition, Event, allocator_type>::value,
+                  int> = 0>
+    auto invoke_action(const Transition& transition,
+                       typename Transition::source_type& s,
+                       Event&& event) -> decltype(auto) {
+        return transition.invoke_action(s, std::forward<Event>(event));
+    }
+
+    template <class Destination,
+              std::enable_if_t<!transition::is_in_place_construct<Destination>::value, int> = 0>
+    auto set_destination(Destination&& destination) -> std::remove_reference_t<Destination>& {
+        return state_.set(std::forward<Destination>(destination));
+    }
+
+    // Construct the destination directly in `state_` after the source has been destroyed.
+    template <class Destination,
+              std::enable_if_t<transition::is_in_place_construct<Destination>::value &&
+                                   !is_recycled_destination<Destination>::value,
+                               int> = 0>
+    auto set_destination(Destination&& destination) -> typename Destination::type& {
+        return construct_destination(std::forward<Destination>(destination));
+    }
+
+    // Reuse a parked destination, reset from the arguments, if the machine has left that state
+    // before.
+    template <class Destination,
+              std::enable_if_t<is_recycled_destination<Destination>::value, int> = 0>
+    auto set_destination(Destination&& destination) -> typename Destination::type& {
+        using state_type = typename Destination::type;
+
+        if (!this->template is_parked<state_type>()) {
+            return construct_destination(std::forward<Destination>(destination));
+        }
+
+        auto& d = state_.set(this->template take<state_type>());
+        std::move(destination).apply(
+            [&d](auto&&... args) { d.reset(std::forward<decltype(args)>(args)...); });
+        return d;
+    }
+
+    template <class Destination>
+    auto construct_destination(Destination&& destination) -> typename Destination::type& {
+        using state_type = typename Destination::type;
+
+        return std::move(destination).apply([this](auto&&... args) -> state_type& {
+            return this->template emplace_state<state_type>(std::forward<decltype(args)>(args)...);
+        });
+    }
+
+    template <class... Args>
+    auto enter_initial_state(Args&&... args) -> void {
+        emplace_state<initial_state_type>(std::forward<Args>(args)...);
+        state_.visit([](auto&& s) { detail::on_entry(std::forward<decltype(s)>(s)); });
+    }
+
+    template <class State, class... Args>
+    auto emplace_state(Args&&... args) -> State& {
+        using construction =
+            typename detail::uses_allocator_construction<allocator_type, State, Args...>::type;
+
+        return emplace_state_with<State>(construction{}, std::forward<Args>(args)...);
+    }
+
+    template <class State, class... Args>
+    auto emplace_state_with(detail::construct_plain, Args&&... args) -> State& {
+        return state_.template emplace<State>(std::forward<Args>(args)...);
+    }
+
+    template <class State, class... Args>
+    auto emplace_state_with(detail::construct_leading, Args&&... args) -> State& {
+        return state_.template emplace<State>(
+            std::allocator_arg, this->allocator(), std::forward<Args>(args)...);
+    }
+
+    template <class State, class... Args>
+    auto emplace_state_with(detail::construct_trailing, Args&&... args) -> State& {
+        return state_.template emplace<State>(std::forward<Args>(args)..., this->allocator());
+    }
+
+    detail::state_variant<state_storage_type> state_;
 };
 
+template <class Table, class Policy>
+constexpr bool StateMachine<Table, Policy>::never_empty;
+
 } // namespace state_machine
 } // namespace state_machine
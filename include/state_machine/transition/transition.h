@@ -4,18 +4,84 @@
 #include "state_machine/containers.h"
 #include "state_machine/traits.h"
 
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace state_machine {
 namespace transition {
 
 using ::state_machine::containers::basic::identity;
 
+// The result of an action that constructs the destination state in place. The constructor
+// arguments are held by value as they must outlive the source state, which is destroyed before the
+// destination is constructed in its storage. An argument that owns heap memory, such as a
+// `std::vector`, is moved twice without copying its contents. An argument whose data is held
+// inline, such as a `std::array`, is still copied into the result and then into the destination,
+// and both copies are alive while the destination is constructed.
+template <class T, class... Args>
+class in_place_construct {
+  public:
+    using type = T;
+
+    template <class... Us>
+    constexpr explicit in_place_construct(Us&&... args) noexcept(
+        std::is_nothrow_constructible<std::tuple<Args...>, Us&&...>::value)
+        : args_{std::forward<Us>(args)...} {}
+
+    // Invoke `callable` with the stored constructor arguments.
+    template <class Callable>
+    constexpr decltype(auto) apply(Callable&& callable) && {
+        return std::move(*this).apply_impl(std::forward<Callable>(callable),
+                                           std::index_sequence_for<Args...>{});
+    }
+
+    // Allows an action returning `in_place_construct<T, ...>` to be used wherever an action
+    // returning `T` is expected.
+    // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+    constexpr operator T() && {
+        return std::move(*this).apply([](auto&&... args) {
+            return T{std::forward<decltype(args)>(args)...};
+        });
+    }
+
+  private:
+    template <class Callable, size_t... Is>
+    constexpr decltype(auto) apply_impl(Callable&& callable, std::index_sequence<Is...>) && {
+        return std::forward<Callable>(callable)(std::get<Is>(std::move(args_))...);
+    }
+
+    std::tuple<Args...> args_;
+};
+
+// Create the result of an action that constructs the destination state `T` in place from `args`,
+// avoiding a temporary destination state and a move into the state machine storage. The `args` are
+// stored by value in the result, see `in_place_construct`.
+template <class T, class... Args>
+constexpr auto emplace(Args&&... args) {
+    return in_place_construct<T, std::decay_t<Args>...>{std::forward<Args>(args)...};
+}
+
+template <class T>
+struct is_in_place_construct : aux::is_specialization_of<in_place_construct, std::decay_t<T>> {};
+
 template <class T>
 struct State {
     using type = T;
 };
 
+// Marks the destination of an external self-transition, as in `state<reuse<S>>`, whose action
+// updates the live source state instead of the state being destroyed and constructed again. A
+// destination returned by value is move-assigned to the source state, and the action may also
+// mutate the source state and return it by reference.
+template <class T>
+struct reuse {};
+
+template <class T>
+struct State<reuse<T>> {
+    using type = T;
+};
+
 template <class T>
 struct Event {
     using type = T;
@@ -35,13 +101,19 @@ struct is_state : aux::is_specialization_of<State, std::decay_t<T>> {};
 template <class T>
 struct is_event : aux::is_specialization_of<Event, std::decay_t<T>> {};
 
-template <class Result, class Callable, class Source, class Event>
-using is_transition_callable =
-    stdx::conjunction<stdx::negation<std::is_null_pointer<Callable>>,
-                      stdx::disjunction<stdx::is_invocable_r<Result, Callable>,
-                                        stdx::is_invocable_r<Result, Callable, Event>,
-                                        stdx::is_invocable_r<Result, Callable, Source>,
-                                        stdx::is_invocable_r<Result, Callable, Source, Event>>>;
+template <class T>
+struct is_reused_state : std::false_type {};
+
+template <class T>
+struct is_reused_state<State<reuse<T>>> : std::true_type {};
+
+template <class Result, class Callable, class Source, class Event, class... Extra>
+using is_transition_callable = stdx::conjunction<
+    stdx::negation<std::is_null_pointer<Callable>>,
+    stdx::disjunction<stdx::is_invocable_r<Result, Callable, Extra...>,
+                      stdx::is_invocable_r<Result, Callable, Event, Extra...>,
+                      stdx::is_invocable_r<Result, Callable, Source, Extra...>,
+                      stdx::is_invocable_r<Result, Callable, Source, Event, Extra...>>>;
 
 template <class T>
 using as_action_arg = std::add_lvalue_reference_t<T>;
@@ -49,12 +121,130 @@ using as_action_arg = std::add_lvalue_reference_t<T>;
 template <class T>
 using as_guard_arg = std::add_const_t<as_action_arg<T>>;
 
+// The type returned by `Transition::action`. Actions returning an `in_place_construct` for the
+// destination keep that result, as do actions of transitions reusing the state `Reused` that return
+// a reference to it. All others are converted to the destination type. `Reused` is void for other
+// transitions.
+template <class Result, class Reused, class Destination>
+struct action_result {
+    using type = Destination;
+};
+
+template <class Reused, class Destination, class... Args>
+struct action_result<in_place_construct<Destination, Args...>, Reused, Destination> {
+    using type = in_place_construct<Destination, Args...>;
+};
+
+template <class Destination>
+struct action_result<Destination&, Destination, Destination> {
+    using type = Destination&;
+};
+
+template <class Result, class Reused, class Destination>
+using action_result_t = typename action_result<
+    std::conditional_t<std::is_lvalue_reference<Result>::value, Result, std::decay_t<Result>>,
+    Reused,
+    Destination>::type;
+
 template <class Callable, class Source, class Event>
 using is_guard = is_transition_callable<bool, Callable, as_guard_arg<Source>, as_guard_arg<Event>>;
 
-template <class Result, class Callable, class Source, class Event>
-using is_action =
-    is_transition_callable<Result, Callable, as_action_arg<Source>, as_action_arg<Event>>;
+// Actions of transitions reusing the state `Reused` may also return a reference to the (possibly
+// mutated) source state.
+template <class Result, class Reused, class Callable, class... Args>
+using is_action_invocable = stdx::disjunction<
+    stdx::is_invocable_r<Result, Callable, Args...>,
+    stdx::conjunction<
+        std::is_same<Reused, Result>,
+        stdx::is_invocable_r<std::add_lvalue_reference_t<Result>, Callable, Args...>>>;
+
+template <class Result, class Reused, class Callable, class Source, class EventArg, class... Extra>
+using is_action_with_event_arg = stdx::disjunction<
+    is_transition_callable<Result, Callable, as_action_arg<Source>, EventArg, Extra...>,
+    stdx::conjunction<std::is_same<Reused, Result>,
+                      is_transition_callable<std::add_lvalue_reference_t<Result>,
+                                             Callable,
+                                             as_action_arg<Source>,
+                                             EventArg,
+                                             Extra...>>>;
+
+template <class Result, class Reused, class Callable, class Source, class Event, class... Extra>
+using is_action_with_extra = stdx::disjunction<
+    is_action_with_event_arg<Result, Reused, Callable, Source, as_action_arg<Event>, Extra...>,
+    is_action_with_event_arg<Result, Reused, Callable, Source, Event&&, Extra...>>;
+
+template <class Result, class Reused, class Callable, class Source, class Event, class Allocator>
+struct is_action_with_allocator
+    : is_action_with_extra<Result, Reused, Callable, Source, Event, const Allocator&> {};
+
+template <class Result, class Reused, class Callable, class Source, class Event>
+struct is_action_with_allocator<Result, Reused, Callable, Source, Event, void> : std::false_type {};
+
+// Stands in for the allocator of a StateMachine when a Transition is checked on its own, as the
+// allocator type is only known from the policy of the machine.
+struct any_allocator {
+    template <class Allocator>
+    operator const Allocator&() const noexcept; // NOLINT(google-explicit-constructor)
+};
+
+// Actions may also take the allocator of a StateMachine whose policy has an `Allocator` as a last
+// argument.
+template <class Result,
+          class Reused,
+          class Callable,
+          class Source,
+          class Event,
+          class Allocator = void>
+using is_action = stdx::disjunction<
+    is_action_with_extra<Result, Reused, Callable, Source, Event>,
+    is_action_with_allocator<Result, Reused, Callable, Source, Event, Allocator>>;
+
+// How an event is passed to an action.
+// Forward the event with its value category.
+struct pass_forward {};
+// Pass an rvalue event as an lvalue, to an action taking `Event&`.
+struct pass_lvalue {};
+// A const event given to an action taking `Event&`. This is rejected rather than silently
+// passing a copy that the action would modify.
+struct pass_const {};
+// The action cannot be invoked with the event.
+struct pass_none {};
+
+// Check if the event is passed to the action.
+template <class Pass>
+using is_passed = stdx::negation<
+    stdx::disjunction<std::is_same<Pass, pass_const>, std::is_same<Pass, pass_none>>>;
+
+// The result of invoking an action with a const event that it takes as `Event&`.
+struct const_event_result {};
+
+template <template <class> class IsInvocable, class Event>
+using event_pass_t = std::conditional_t<
+    IsInvocable<Event&&>::value,
+    pass_forward,
+    std::conditional_t<!std::is_const<std::remove_reference_t<Event>>::value &&
+                           IsInvocable<std::remove_reference_t<Event>&>::value,
+                       pass_lvalue,
+                       std::conditional_t<IsInvocable<std::decay_t<Event>&>::value,
+                                          pass_const,
+                                          pass_none>>>;
+
+// The type of the event argument passed to an action.
+template <class Pass, class Event>
+using passed_event_t = std::conditional_t<std::is_same<Pass, pass_forward>::value,
+                                          Event&&,
+                                          std::remove_reference_t<Event>&>;
+
+// Invoke `f` with `event` as described by the pass tag.
+template <class Event, class F>
+constexpr auto pass_event(pass_forward, Event&& event, F&& f) -> decltype(auto) {
+    return std::forward<F>(f)(std::forward<Event>(event));
+}
+
+template <class Event, class F>
+constexpr auto pass_event(pass_lvalue, Event&& event, F&& f) -> decltype(auto) {
+    return std::forward<F>(f)(event);
+}
 
 } // namespace detail
 
@@ -86,10 +276,26 @@ struct Transition : Guard, Action {
     using destination_type = typename Destination::type;
     static constexpr bool internal = std::is_void<destination_type>::value;
 
+    // An external self-transition marked with `reuse`. The live state object is reused instead of
+    // being destroyed and constructed again.
+    static constexpr bool self = detail::is_reused_state<Destination>::value;
+
+    static_assert(!self || std::is_same<source_type, destination_type>::value,
+                  "Only the destination of a transition from the same state can be marked "
+                  "`reuse`.");
+
+    // The state reused by the transition, or void.
+    using reused_type = std::conditional_t<self, source_type, void>;
+
     static_assert(
         detail::is_guard<Guard, source_type, event_type>::value,
         "`Guard` type parameter must be callable with `Source` and/or `Event` and return bool.");
-    static_assert(detail::is_action<destination_type, Action, source_type, event_type>::value,
+    // Check if `Action` can be invoked by a StateMachine whose policy has `Allocator`.
+    template <class Allocator>
+    using is_action_for = detail::
+        is_action<destination_type, reused_type, Action, source_type, event_type, Allocator>;
+
+    static_assert(is_action_for<detail::any_allocator>::value,
                   "`Action` type parameter must be callable with `Source` and/or `Event` and "
                   "return `Destination`.");
 
@@ -110,7 +316,10 @@ struct Transition : Guard, Action {
     template <class... Ts>
     auto action(Ts&&... ts) const
         noexcept(noexcept(std::declval<Action>().operator()(std::forward<Ts>(ts)...)))
-            -> destination_type {
+            -> detail::action_result_t<decltype(std::declval<const Action&>()(
+                                           std::forward<Ts>(ts)...)),
+                                       reused_type,
+                                       destination_type> {
         return Action::operator()(std::forward<Ts>(ts)...);
     }
 
@@ -143,38 +352,111 @@ struct Transition : Guard, Action {
         return guard(source, event);
     }
 
-    template <class R = destination_type,
-              std::enable_if_t<stdx::is_invocable_r<R, Action>::value, int> = 0>
-    auto invoke_action(source_type&, event_type&) const
-        noexcept(noexcept(std::declval<type>().action())) -> destination_type {
-        return action();
+    // Check if `Action` can be invoked with an event argument of type `Arg`, optionally preceded by
+    // the source state and followed by arguments of type `Extra`.
+    template <class... Extra>
+    struct action_args {
+        template <class Arg>
+        using with_event = detail::
+            is_action_invocable<destination_type, reused_type, Action, Arg, const Extra&...>;
+
+        template <class Arg>
+        using with_source_event = detail::is_action_invocable<destination_type,
+                                                              reused_type,
+                                                              Action,
+                                                              source_type&,
+                                                              Arg,
+                                                              const Extra&...>;
+    };
+
+    template <class Ev, class... Extra>
+    using event_pass = detail::event_pass_t<action_args<Extra...>::template with_event, Ev>;
+
+    template <class Ev, class... Extra>
+    using source_event_pass =
+        detail::event_pass_t<action_args<Extra...>::template with_source_event, Ev>;
+
+    // Events are passed to actions with the value category given to `invoke_action` where
+    // possible, so an action may take an rvalue event and move from it. An rvalue event is passed
+    // as an lvalue to actions taking `Event&`. Events are never copied, so a const event given
+    // to an action taking `Event&` fails to compile.
+    //
+    // Any `extra` arguments, such as an allocator, are passed after the source state and event and
+    // only select actions that accept them.
+
+    template <class Ev,
+              class... Extra,
+              class R = destination_type,
+              std::enable_if_t<
+                  detail::is_action_invocable<R, reused_type, Action, const Extra&...>::value,
+                  int> = 0>
+    auto invoke_action(source_type&, Ev&&, const Extra&... extra) const
+        noexcept(noexcept(std::declval<type>().action(std::declval<const Extra&>()...)))
+            -> decltype(auto) {
+        return action(extra...);
     }
 
-    template <class R = destination_type,
-              std::enable_if_t<stdx::is_invocable_r<R, Action, source_type&>::value, int> = 0>
-    auto invoke_action(source_type& source, event_type&) const
-        noexcept(noexcept(std::declval<type>().action(std::declval<source_type&>())))
-            -> destination_type {
-        return action(source);
+    template <class Ev,
+              class... Extra,
+              class R = destination_type,
+              std::enable_if_t<detail::is_action_invocable<R,
+                                                           reused_type,
+                                                           Action,
+                                                           source_type&,
+                                                           const Extra&...>::value,
+                               int> = 0>
+    auto invoke_action(source_type& source, Ev&&, const Extra&... extra) const
+        noexcept(noexcept(std::declval<type>().action(std::declval<source_type&>(),
+                                                      std::declval<const Extra&>()...)))
+            -> decltype(auto) {
+        return action(source, extra...);
     }
 
-    template <class R = destination_type,
-              std::enable_if_t<stdx::is_invocable_r<R, Action, event_type&>::value, int> = 0>
-    auto invoke_action(source_type&, event_type& event) const
+    template <class Ev,
+              class... Extra,
+              std::enable_if_t<detail::is_passed<event_pass<Ev, Extra...>>::value, int> = 0>
+    auto invoke_action(source_type&, Ev&& event, const Extra&... extra) const
+        noexcept(noexcept(std::declval<type>().action(
+            std::declval<detail::passed_event_t<event_pass<Ev, Extra...>, Ev>>(),
+            std::declval<const Extra&>()...))) -> decltype(auto) {
+        return detail::pass_event(
+            event_pass<Ev, Extra...>{}, std::forward<Ev>(event), [&](auto&& e) -> decltype(auto) {
+                return this->action(std::forward<decltype(e)>(e), extra...);
+            });
+    }
 
-        noexcept(noexcept(std::declval<type>().action(std::declval<event_type&>())))
-            -> destination_type {
-        return action(event);
+    template <class Ev,
+              class... Extra,
+              std::enable_if_t<detail::is_passed<source_event_pass<Ev, Extra...>>::value, int> = 0>
+    auto invoke_action(source_type& source, Ev&& event, const Extra&... extra) const
+        noexcept(noexcept(std::declval<type>().action(
+            std::declval<source_type&>(),
+            std::declval<detail::passed_event_t<source_event_pass<Ev, Extra...>, Ev>>(),
+            std::declval<const Extra&>()...))) -> decltype(auto) {
+        return detail::pass_event(source_event_pass<Ev, Extra...>{},
+                                  std::forward<Ev>(event),
+                                  [&](auto&& e) -> decltype(auto) {
+                                      return this->action(
+                                          source, std::forward<decltype(e)>(e), extra...);
+                                  });
     }
 
-    template <class R = destination_type,
-              std::enable_if_t<stdx::is_invocable_r<R, Action, source_type&, event_type&>::value,
-                               int> = 0>
-    auto invoke_action(source_type& source, event_type& event) const
-        noexcept(noexcept(std::declval<type>().action(std::declval<source_type&>(),
-                                                      std::declval<event_type&>())))
-            -> destination_type {
-        return action(source, event);
+    // A const event is not copied for an action taking `Event&`, as the action would modify the
+    // copy instead of the event. The result type is declared so that checking which arguments an
+    // action accepts does not instantiate the body, which only fails once the action is invoked.
+    template <class Ev,
+              class... Extra,
+              std::enable_if_t<
+                  !detail::is_passed<event_pass<Ev, Extra...>>::value &&
+                      !detail::is_passed<source_event_pass<Ev, Extra...>>::value &&
+                      (std::is_same<event_pass<Ev, Extra...>, detail::pass_const>::value ||
+                       std::is_same<source_event_pass<Ev, Extra...>, detail::pass_const>::value),
+                  int> = 0>
+    auto invoke_action(source_type&, Ev&&, const Extra&...) const -> detail::const_event_result {
+        static_assert(!std::is_const<std::remove_reference_t<Ev>>::value,
+                      "The action takes a non-const `Event&` but the event is const. Take "
+                      "`const Event&` or pass a non-const event.");
+        return {};
     }
 };
 
@@ -78,14 +78,18 @@ class Row {
                                 std::forward<U>(transition));
     }
 
-    template <class S, class E>
-    constexpr auto find_transition_impl(S, E, std::index_sequence<>) const -> optional<size_t> {
+    // The source state and event are passed by reference so that evaluating guards does not copy
+    // them, regardless of the number of candidate transitions.
+    constexpr auto find_transition_impl(const source_type&,
+                                        const event_type&,
+                                        std::index_sequence<>) const -> optional<size_t> {
         return {};
     }
 
-    template <class S, class E, size_t I, size_t... Is>
-    constexpr auto find_transition_impl(S source, E event, std::index_sequence<I, Is...>) const
-        -> optional<size_t> {
+    template <size_t I, size_t... Is>
+    constexpr auto find_transition_impl(const source_type& source,
+                                        const event_type& event,
+                                        std::index_sequence<I, Is...>) const -> optional<size_t> {
         return std::get<I>(data_).invoke_guard(source, event) ?
                    optional<size_t>{I} :
                    find_transition_impl(source, event, std::index_sequence<Is...>{});
@@ -6,6 +6,9 @@
 #include "state_machine/transition/transition.h"
 #include "state_machine/transition/transition_row.h"
 
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <tuple>
 #include <utility>
 
@@ -86,6 +89,52 @@ struct get_destinations {
     using type = typename R::destination_types;
 };
 
+template <class RowIndexType, RowIndexType Undefined, class RowIndexConstant>
+constexpr auto as_row_index(RowIndexConstant) noexcept -> RowIndexType {
+    return static_cast<RowIndexType>(RowIndexConstant::value);
+}
+
+template <class RowIndexType, RowIndexType Undefined>
+constexpr auto as_row_index(void*) noexcept -> RowIndexType {
+    return Undefined;
+}
+
+// Look up the row index for element `K` of a flattened [state][event] matrix.
+template <class RowIndexType,
+          RowIndexType Undefined,
+          class RowIndexMap,
+          class StateIndexMap,
+          class EventIndexMap,
+          size_t K>
+constexpr auto transition_matrix_element() noexcept -> RowIndexType {
+    constexpr size_t num_events = op::size<typename EventIndexMap::keys>::value;
+
+    using state_type =
+        typename StateIndexMap::template at_value<aux::index_constant<K / num_events>>;
+    using event_type =
+        typename EventIndexMap::template at_value<aux::index_constant<K % num_events>>;
+    using key_type = Key<State<state_type>, Event<event_type>>;
+
+    return as_row_index<RowIndexType, Undefined>(
+        typename RowIndexMap::template at_key<key_type, void*>{});
+}
+
+template <class RowIndexType,
+          RowIndexType Undefined,
+          class RowIndexMap,
+          class StateIndexMap,
+          class EventIndexMap,
+          size_t... Ks>
+constexpr auto make_transition_matrix(std::index_sequence<Ks...>) noexcept
+    -> std::array<RowIndexType, sizeof...(Ks)> {
+    return {{transition_matrix_element<RowIndexType,
+                                       Undefined,
+                                       RowIndexMap,
+                                       StateIndexMap,
+                                       EventIndexMap,
+                                       Ks>()...}};
+}
+
 } // namespace detail
 
 template <class R, class... Rs>
@@ -100,6 +149,37 @@ class Table {
     using data_type = std::tuple<R, Rs...>;
     static constexpr size_t size = 1 + sizeof...(Rs);
 
+    // Indices of `state_types` and `event_types`, used to address `transition_matrix`.
+    using state_index_map = op::repack<state_types, index_map>;
+    using event_index_map = op::repack<event_types, index_map>;
+    static constexpr size_t num_states = op::size<state_types>::value;
+    static constexpr size_t num_events = op::size<event_types>::value;
+
+    using row_index_type =
+        std::conditional_t<(size < std::numeric_limits<uint8_t>::max()), uint8_t, uint16_t>;
+
+    static_assert(size < std::numeric_limits<uint16_t>::max(),
+                  "Number of rows exceeds Table maximum.");
+
+    // The value of a `transition_matrix` element if no row is defined for a state and event.
+    static constexpr row_index_type undefined_row = std::numeric_limits<row_index_type>::max();
+
+    // A dense [state][event] matrix, flattened in row-major order, where each element is the index
+    // of the row in `data()` or `undefined_row`.
+    using transition_matrix_type = std::array<row_index_type, num_states * num_events>;
+    static constexpr transition_matrix_type transition_matrix =
+        detail::make_transition_matrix<row_index_type,
+                                       undefined_row,
+                                       row_index_map,
+                                       state_index_map,
+                                       event_index_map>(
+            std::make_index_sequence<num_states * num_events>{});
+
+    static constexpr auto row_index(size_t state_index, size_t event_index) noexcept
+        -> row_index_type {
+        return transition_matrix[(state_index * num_events) + event_index];
+    }
+
     constexpr explicit Table(R&& first, Rs&&... others) noexcept
         : data_{std::make_tuple(std::forward<R>(first), std::forward<Rs>(others)...)} {}
 
@@ -158,6 +238,12 @@ class Table {
     std::tuple<R, Rs...> data_;
 };
 
+template <class R, class... Rs>
+constexpr typename Table<R, Rs...>::transition_matrix_type Table<R, Rs...>::transition_matrix;
+
+template <class R, class... Rs>
+constexpr typename Table<R, Rs...>::row_index_type Table<R, Rs...>::undefined_row;
+
 template <class T>
 using is_table = aux::is_specialization_of<Table, T>;
 
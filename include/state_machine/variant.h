@@ -2,9 +2,14 @@
 
 #include "state_machine/backport.h"
 #include "state_machine/containers.h"
+#include "state_machine/error.h"
+#include "state_machine/slab_pool.h"
 #include "state_machine/traits.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
 
@@ -13,6 +18,7 @@ namespace variant {
 
 using ::state_machine::containers::bijection;
 using ::state_machine::containers::index_map;
+using ::state_machine::containers::list;
 namespace op = ::state_machine::containers::op;
 
 // The type of exception thrown if `Variant::get` is called with the wrong type.
@@ -22,28 +28,378 @@ class bad_variant_access : public std::exception {};
 // types are taken.
 struct empty {};
 
+// Layouts for the index of the alternative held by a Variant.
+struct separate_index {};
+struct packed_index {};
+
+// Marks an alternative `T` of a Variant that is stored out of line in a slot of a
+// `pool::slab_pool`. Only a pointer is stored in the Variant, so a large alternative does not
+// increase the size of the Variant. The alternative is accessed as `T`. Moving the Variant
+// transfers the slot, leaving the moved-from Variant empty.
+template <class T>
+struct boxed {
+    using type = T;
+};
+
+template <class T>
+struct unboxed {
+    using type = T;
+};
+
+template <class T>
+struct unboxed<boxed<T>> {
+    using type = T;
+};
+
+template <class T>
+using unboxed_t = typename unboxed<T>::type;
+
+namespace detail {
+
+// Provides unchecked access to the alternatives of a Variant for the free `visit` function.
+struct access {
+    template <class T, class V>
+    static auto get(V& v) noexcept -> decltype(auto) {
+        return v.template get_unchecked<T>();
+    }
+};
+
+template <class T>
+using move_or_copy_t = std::conditional_t<std::is_move_constructible<T>::value, T&&, const T&>;
+
+using index_type = std::uint8_t;
+
+// How an alternative is held in Variant storage.
+template <class T>
+struct alternative_traits {
+    using stored_type = T;
+
+    using is_trivially_copyable =
+        stdx::conjunction<std::is_trivially_copyable<T>, std::is_trivially_destructible<T>>;
+    using is_trivially_destructible = std::is_trivially_destructible<T>;
+    using is_nothrow_destructible = std::is_nothrow_destructible<T>;
+    using is_nothrow_move_constructible = std::is_nothrow_constructible<T, move_or_copy_t<T>>;
+
+    // Set if moving the alternative out of a Variant leaves that Variant empty.
+    static constexpr bool moves_storage = false;
+
+    static auto get(void* p) noexcept -> T& { return *static_cast<T*>(p); }
+    static auto get(const void* p) noexcept -> const T& { return *static_cast<const T*>(p); }
+
+    template <class... Args>
+    static auto construct(void* p, Args&&... args) noexcept(noexcept(T{
+        std::forward<Args>(args)...})) -> T& {
+        return *new (p) T{std::forward<Args>(args)...};
+    }
+
+    static auto destroy(void* p) noexcept(is_nothrow_destructible::value) -> void {
+        get(p).T::~T();
+    }
+
+    static auto move_construct(void* p, void* rhs) noexcept(is_nothrow_move_constructible::value)
+        -> void {
+        construct(p, static_cast<move_or_copy_t<T>>(get(rhs)));
+    }
+};
+
+template <class T>
+struct alternative_traits<boxed<T>> {
+    using stored_type = T*;
+    using pool_type = pool::slab_pool<T>;
+
+    using is_trivially_copyable = std::false_type;
+    using is_trivially_destructible = std::false_type;
+    using is_nothrow_destructible = std::is_nothrow_destructible<T>;
+    using is_nothrow_move_constructible = std::true_type;
+
+    static constexpr bool moves_storage = true;
+
+    static auto get(void* p) noexcept -> T& { return **static_cast<T**>(p); }
+    static auto get(const void* p) noexcept -> const T& { return **static_cast<T* const*>(p); }
+
+    template <class... Args>
+    static auto construct(void* p, Args&&... args) -> T& {
+        // Return the slot to the pool if construction of `T` throws.
+        struct slot_guard {
+            slot_guard(const slot_guard&) = delete;
+            slot_guard(slot_guard&&) = delete;
+            auto operator=(const slot_guard&) -> slot_guard& = delete;
+            auto operator=(slot_guard&&) -> slot_guard& = delete;
+            ~slot_guard() {
+                if (slot != nullptr) {
+                    pool_type::deallocate(slot);
+                }
+            }
+            void* slot;
+        };
+
+        slot_guard guard{pool_type::allocate()};
+        auto* t = new (guard.slot) T{std::forward<Args>(args)...};
+        guard.slot = nullptr;
+
+        new (p) stored_type{t};
+        return *t;
+    }
+
+    static auto destroy(void* p) noexcept(is_nothrow_destructible::value) -> void {
+        auto* t = *static_cast<T**>(p);
+        t->T::~T();
+        pool_type::deallocate(t);
+    }
+
+    static auto move_construct(void* p, void* rhs) noexcept -> void {
+        new (p) stored_type{*static_cast<T**>(rhs)};
+    }
+};
+
+// Size and alignment of storage for a set of alternatives.
 template <class... Ts>
-class Variant {
+struct alternatives_layout {
+    static constexpr std::size_t size = std::max({sizeof(empty), sizeof(Ts)...});
+    static constexpr std::size_t alignment = std::max({alignof(empty), alignof(Ts)...});
+    static constexpr std::size_t aligned_size = ((size + alignment - 1) / alignment) * alignment;
+
+    // If no alternative extends into the last byte of aligned storage, the index can be stored
+    // there instead of after the storage.
+    static constexpr bool has_spare_tail_byte = size < aligned_size;
+};
+
+// Alternative storage followed by a separate index.
+template <class... Ts>
+class separate_index_storage {
+  protected:
+    constexpr auto stored_index() const noexcept -> index_type { return index_; }
+    auto set_stored_index(index_type value) noexcept -> void { index_ = value; }
+
+    auto address() noexcept -> void* { return std::addressof(storage_); }
+    auto address() const noexcept -> const void* { return std::addressof(storage_); }
+
+  private:
+    std::aligned_union_t<0, empty, Ts...> storage_ = {};
+    index_type index_ = 0;
+};
+
+// Alternative storage with the index stored in the last byte, which is never part of an
+// alternative.
+template <class... Ts>
+class packed_index_storage {
+    using layout = alternatives_layout<Ts...>;
+    static_assert(layout::has_spare_tail_byte, "");
+
+    static constexpr std::size_t index_offset = layout::aligned_size - 1;
+
+  protected:
+    constexpr auto stored_index() const noexcept -> index_type { return bytes_[index_offset]; }
+    auto set_stored_index(index_type value) noexcept -> void { bytes_[index_offset] = value; }
+
+    auto address() noexcept -> void* { return std::addressof(bytes_); }
+    auto address() const noexcept -> const void* { return std::addressof(bytes_); }
+
+  private:
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+    alignas(layout::alignment) unsigned char bytes_[layout::aligned_size] = {};
+};
+
+template <class Layout, class... Ts>
+struct storage_for;
+
+template <class... Ts>
+struct storage_for<separate_index, Ts...> {
+    using type = separate_index_storage<Ts...>;
+};
+
+template <class... Ts>
+struct storage_for<packed_index, Ts...> {
+    using type = std::conditional_t<alternatives_layout<Ts...>::has_spare_tail_byte,
+                                    packed_index_storage<Ts...>,
+                                    separate_index_storage<Ts...>>;
+};
+
+// Storage for the alternatives of a Variant and the index of the alternative currently held.
+// Alternatives are dispatched with a table of function pointers indexed by the stored index, so
+// the cost of destruction and move construction does not depend on the number of alternatives.
+template <class Layout, class... Ts>
+class variant_storage
+    : public storage_for<Layout, typename alternative_traits<Ts>::stored_type...>::type {
+  public:
+    using alternative_index_map = index_map<empty, unboxed_t<Ts>...>;
+    using index_type = detail::index_type;
+
+  protected:
+    // The traits of the alternative accessed as `T`.
+    template <class T>
+    using traits_for = alternative_traits<
+        std::conditional_t<op::contains<boxed<T>, list<Ts...>>::value, boxed<T>, T>>;
+
+    template <class T>
+    static constexpr auto alternative_index() noexcept {
+        return static_cast<index_type>(alternative_index_map::template at_key<T>::value);
+    }
+
+    template <class T>
+    inline auto get_unchecked() noexcept -> T& {
+        return traits_for<T>::get(this->address());
+    }
+
+    template <class T>
+    inline auto get_unchecked() const noexcept -> const T& {
+        return traits_for<T>::get(this->address());
+    }
+
+    // Construct `T` in this storage, which must be empty, without updating the index.
+    template <class T, class... Args>
+    inline auto construct(Args&&... args) noexcept(
+        noexcept(traits_for<T>::construct(std::declval<void*>(), std::forward<Args>(args)...)))
+        -> T& {
+        return traits_for<T>::construct(this->address(), std::forward<Args>(args)...);
+    }
+
+    inline auto destroy_internal() noexcept(
+        stdx::conjunction<typename alternative_traits<Ts>::is_nothrow_destructible...>::value)
+        -> void {
+        if (stdx::conjunction<
+                typename alternative_traits<Ts>::is_trivially_destructible...>::value) {
+            return;
+        }
+
+        using destroy_handler_type = void (*)(variant_storage&);
+        static constexpr destroy_handler_type handlers[] = {
+            &variant_storage::destroy_alternative<empty>,
+            &variant_storage::destroy_alternative<Ts>...};
+        handlers[this->stored_index()](*this);
+    }
+
+    // Move construct the alternative held by `rhs` into this storage, which must be empty.
+    // Alternatives that are not move constructible are copied. Boxed alternatives are transferred,
+    // leaving `rhs` empty.
+    inline auto move_construct_from(variant_storage& rhs) noexcept(
+        stdx::conjunction<typename alternative_traits<Ts>::is_nothrow_move_constructible...>::value)
+        -> void {
+        using move_handler_type = void (*)(variant_storage&, variant_storage&);
+        static constexpr move_handler_type handlers[] = {
+            &variant_storage::move_alternative<empty>, &variant_storage::move_alternative<Ts>...};
+        handlers[rhs.stored_index()](*this, rhs);
+    }
+
+  private:
+    template <class T>
+    static auto destroy_alternative(variant_storage& self) noexcept(
+        alternative_traits<T>::is_nothrow_destructible::value) -> void {
+        alternative_traits<T>::destroy(self.address());
+    }
+
+    template <class T>
+    static auto move_alternative(variant_storage& self, variant_storage& rhs) -> void {
+        alternative_traits<T>::move_construct(self.address(), rhs.address());
+        self.set_stored_index(alternative_index<unboxed_t<T>>());
+
+        if (alternative_traits<T>::moves_storage) {
+            rhs.set_stored_index(alternative_index<empty>());
+        }
+    }
+};
+
+// Provides a destructor for Variants with alternatives that are not trivially destructible. The
+// destructor is otherwise trivial.
+template <bool TriviallyDestructible, class Layout, class... Ts>
+class variant_destructor : public variant_storage<Layout, Ts...> {
+  public:
+    variant_destructor() = default;
+    variant_destructor(const variant_destructor&) = default;
+    variant_destructor(variant_destructor&&) noexcept = default;
+    auto operator=(const variant_destructor&) -> variant_destructor& = default;
+    auto operator=(variant_destructor&&) noexcept -> variant_destructor& = default;
+
+    // Destructors of user-defined alternative types may throw
+    // NOLINTNEXTLINE(bugprone-exception-escape)
+    ~variant_destructor() noexcept(
+        stdx::conjunction<typename alternative_traits<Ts>::is_nothrow_destructible...>::value) {
+        this->destroy_internal();
+    }
+};
+
+template <class Layout, class... Ts>
+class variant_destructor<true, Layout, Ts...> : public variant_storage<Layout, Ts...> {};
+
+// Provides move operations for Variants with alternatives that are not trivially copyable. If all
+// alternatives are trivially copyable, the move operations are trivial and a Variant may be copied
+// with `memcpy`.
+template <bool TriviallyCopyable, class Layout, class... Ts>
+class variant_move
+    : public variant_destructor<
+          stdx::conjunction<typename alternative_traits<Ts>::is_trivially_destructible...>::value,
+          Layout,
+          Ts...> {
+  public:
+    variant_move() = default;
+
+    variant_move(const variant_move&) = delete;
+    auto operator=(const variant_move&) -> variant_move& = delete;
+
+    variant_move(variant_move&& rhs) noexcept(
+        noexcept(std::declval<variant_move&>().move_construct_from(rhs))) {
+        this->move_construct_from(rhs);
+    }
+
+    auto operator=(variant_move&& rhs) noexcept(
+        noexcept(std::declval<variant_move&>().destroy_internal()) &&
+        noexcept(std::declval<variant_move&>().move_construct_from(rhs))) -> variant_move& {
+        if (this != std::addressof(rhs)) {
+            this->destroy_internal();
+            // The index is reset before construction so a throwing move leaves this empty.
+            this->set_stored_index(this->template alternative_index<empty>());
+            this->move_construct_from(rhs);
+        }
+        return *this;
+    }
+
+    ~variant_move() = default;
+};
+
+template <class Layout, class... Ts>
+class variant_move<true, Layout, Ts...> : public variant_destructor<true, Layout, Ts...> {};
+
+template <class Layout, class... Ts>
+using variant_base =
+    variant_move<
+        stdx::conjunction<typename alternative_traits<Ts>::is_trivially_copyable...>::value,
+        Layout,
+        Ts...>;
+
+} // namespace detail
+
+// A Variant is trivially copyable and trivially destructible if all alternatives are.
+//
+// `Layout` selects how the index of the held alternative is stored. With `separate_index`, the
+// index follows the alternative storage. With `packed_index`, the index is stored in the last byte
+// of the alternative storage if no alternative uses that byte, which can remove the padding
+// otherwise added after the index. `index_packing` reports if this is possible.
+//
+// An alternative given as `boxed<T>` is stored out of line and accessed as `T`.
+template <class Layout, class... Ts>
+class BasicVariant : private detail::variant_base<Layout, Ts...> {
+    using base_type = detail::variant_base<Layout, Ts...>;
+
   public:
-    using alternative_index_map = index_map<empty, Ts...>;
-    using index_type = uint8_t;
+    using alternative_index_map = typename base_type::alternative_index_map;
+    using index_type = typename base_type::index_type;
 
     // Number of alternative types, excluding the "empty" type.
     static constexpr size_t size = sizeof...(Ts);
 
   private:
-    using type = Variant<Ts...>;
-    using storage_type = std::aligned_union_t<0, empty, Ts...>;
+    using type = BasicVariant<Layout, Ts...>;
 
+    // Boxed alternatives are never copied or moved.
     static_assert(stdx::conjunction<aux::is_copy_or_move_constructible<Ts>...>::value,
                   "Variant can only contain types that are copy or move constructible.");
-    static_assert(stdx::conjunction<std::is_destructible<Ts>...>::value,
+    static_assert(stdx::conjunction<std::is_destructible<unboxed_t<Ts>>...>::value,
                   "Variant can only contain types that are destructible.");
-    static_assert(!stdx::disjunction<std::is_reference<Ts>...>::value,
+    static_assert(!stdx::disjunction<std::is_reference<unboxed_t<Ts>>...>::value,
                   "Variant cannot contain reference types.");
-    static_assert(!stdx::disjunction<std::is_array<Ts>...>::value,
+    static_assert(!stdx::disjunction<std::is_array<unboxed_t<Ts>>...>::value,
                   "Variant cannot contain array types.");
-    static_assert(sizeof...(Ts) < std::numeric_limits<Variant::index_type>::max(),
+    static_assert(sizeof...(Ts) < std::numeric_limits<index_type>::max(),
                   "Number of template type parameters exceeds Variant maximum.");
 
     template <class T>
@@ -51,53 +407,29 @@ class Variant {
         std::enable_if_t<alternative_index_map::template contains_key<T>::value, int>;
 
   public:
-    constexpr Variant() noexcept = default;
-
-    Variant(const Variant&) = delete;
-    auto operator=(const Variant&) -> Variant& = delete;
-
-    Variant(Variant&& rhs) noexcept(
-        // NOLINTNEXTLINE(performance-noexcept-move-constructor)
-        stdx::conjunction<std::is_nothrow_move_constructible<Ts>...>::value) {
-        if (!rhs.holds<empty>()) {
-            on_alternate<op::pop_front<op::repack<alternative_index_map, bijection>>>::invoke(
-                rhs, [this](auto& s) {
-                    using state_type = std::remove_reference_t<decltype(s)>;
-                    if (std::is_nothrow_move_constructible<state_type>::value) {
-                        this->set<state_type>(std::move(s));
-                    }
-                });
-        }
-    }
+    constexpr BasicVariant() noexcept = default;
 
-    // NOLINTNEXTLINE(bugprone-exception-escape)
-    auto operator=(Variant&& rhs) noexcept(
-        // NOLINTNEXTLINE(performance-noexcept-move-constructor)
-        stdx::conjunction<std::is_nothrow_move_assignable<Ts>...>::value) -> Variant& {
-        if (rhs.holds<empty>()) {
-            this->emplace<empty>();
-        } else {
-            // A double move is used to handle self-assignment.
-            auto temp = Variant{std::move(rhs)};
-            temp.visit([this](auto& s) { this->set(std::move(s)); });
-        }
-        return *this;
-    }
+    BasicVariant(const BasicVariant&) = delete;
+    auto operator=(const BasicVariant&) -> BasicVariant& = delete;
 
-    ~Variant() noexcept(noexcept(std::declval<Variant>().destroy_internal())) {
-        destroy_internal();
-    }
+    BasicVariant(BasicVariant&&) = default;
+    auto operator=(BasicVariant&&) -> BasicVariant& = default;
+
+    ~BasicVariant() = default;
 
     template <class T,
               class D = std::remove_reference_t<T>,
               std::enable_if_t<alternative_index_map::template contains_key<D>::value &&
                                    std::is_move_constructible<D>::value,
                                int> = 0>
-    auto set(T&& t) noexcept(noexcept(std::declval<Variant>().destroy_internal()) &&
-                             std::is_nothrow_move_constructible<D>::value) -> D& {
-        destroy_internal();
-        index_ = alternative_index<D>();
-        return *(new (std::addressof(storage_)) D{std::forward<T>(t)});
+    auto set(T&& t) noexcept(noexcept(std::declval<BasicVariant>().destroy_internal()) &&
+                             noexcept(std::declval<BasicVariant>().template construct<D>(
+                                 std::forward<T>(t)))) -> D& {
+        this->destroy_internal();
+        this->set_stored_index(alternative_index<empty>());
+        auto& d = this->template construct<D>(std::forward<T>(t));
+        this->set_stored_index(alternative_index<D>());
+        return d;
     }
 
     template <class T,
@@ -105,20 +437,28 @@ class Variant {
               std::enable_if_t<alternative_index_map::template contains_key<D>::value &&
                                    !std::is_move_constructible<D>::value,
                                int> = 0>
-    auto set(const T& t) noexcept(noexcept(std::declval<Variant>().destroy_internal()) &&
-                                  std::is_nothrow_copy_constructible<D>::value) -> D& {
-        destroy_internal();
-        index_ = alternative_index<D>();
-        return *(new (std::addressof(storage_)) D{t});
+    auto set(const T& t) noexcept(noexcept(std::declval<BasicVariant>().destroy_internal()) &&
+                                  noexcept(std::declval<BasicVariant>().template construct<D>(t)))
+        -> D& {
+        this->destroy_internal();
+        this->set_stored_index(alternative_index<empty>());
+        auto& d = this->template construct<D>(t);
+        this->set_stored_index(alternative_index<D>());
+        return d;
     }
 
     template <class T, class... Args, enable_if_key_t<T> = 0>
-    auto emplace(Args&&... args) noexcept(noexcept(
-        std::declval<Variant>().destroy_internal()) && noexcept(T{std::forward<Args>(args)...}))
+    auto emplace(Args&&... args) noexcept(
+        noexcept(std::declval<BasicVariant>().destroy_internal()) &&
+        noexcept(std::declval<BasicVariant>().template construct<T>(std::forward<Args>(args)...)))
         -> T& {
-        destroy_internal();
-        index_ = alternative_index<T>();
-        return *(new (std::addressof(storage_)) T{std::forward<Args>(args)...});
+        this->destroy_internal();
+        // The index is only updated once construction succeeds so a throwing constructor leaves
+        // the Variant empty.
+        this->set_stored_index(alternative_index<empty>());
+        auto& t = this->template construct<T>(std::forward<Args>(args)...);
+        this->set_stored_index(alternative_index<T>());
+        return t;
     }
 
     template <class T, enable_if_key_t<T> = 0>
@@ -131,7 +471,7 @@ class Variant {
         auto* state = get_impl<T>();
 
         if (state == nullptr) {
-            throw bad_variant_access{};
+            error::raise(bad_variant_access{});
         }
 
         return *state;
@@ -139,7 +479,13 @@ class Variant {
 
     template <class T, enable_if_key_t<T> = 0>
     auto get() const -> const T& {
-        return get();
+        const auto* state = get_impl<T>();
+
+        if (state == nullptr) {
+            error::raise(bad_variant_access{});
+        }
+
+        return *state;
     }
 
     template <class T, enable_if_key_t<T> = 0>
@@ -179,71 +525,160 @@ class Variant {
                       "`visit` cannot be called if Variant is not defined with any alternatives.");
 
         if (holds<empty>()) {
-            throw bad_variant_access{};
+            error::raise(bad_variant_access{});
+        }
+
+        return visit_impl(*this, callable);
+    }
+
+    template <class Callable>
+    auto visit(Callable callable) const {
+        static_assert(sizeof...(Ts) > 0,
+                      "`visit` cannot be called if Variant is not defined with any alternatives.");
+
+        if (holds<empty>()) {
+            error::raise(bad_variant_access{});
         }
 
-        return on_alternate<op::pop_front<op::repack<alternative_index_map, bijection>>>::invoke(
-            *this, callable);
+        return visit_impl(*this, callable);
     }
 
-    constexpr auto index() const noexcept -> index_type { return index_; }
+    constexpr auto index() const noexcept -> index_type { return this->stored_index(); }
 
     template <class T, enable_if_key_t<T> = 0>
     static constexpr auto alternative_index() noexcept {
-        return static_cast<index_type>(alternative_index_map::template at_key<T>::value);
+        return base_type::template alternative_index<T>();
     }
 
   private:
-    template <class Mapping>
-    struct on_alternate;
+    friend struct detail::access;
 
-    template <class Entry>
-    struct on_alternate<bijection<Entry>> {
+    template <class Self, class T>
+    using match_const_t = std::conditional_t<std::is_const<Self>::value, const T, T>;
 
-        template <class Callable>
-        static constexpr auto invoke(type& self, const Callable& callable) {
-            using T = typename Entry::first_type;
-            if (self.index() == Entry::second_type::value) {
-                return callable(self.get<T>());
-            }
-            __builtin_unreachable();
-        }
-    };
-
-    template <class Entry, class Next, class... Rest>
-    struct on_alternate<bijection<Entry, Next, Rest...>>
-        : private on_alternate<bijection<Next, Rest...>> {
-
-        template <class Callable>
-        static constexpr auto invoke(type& self, const Callable& callable) {
-            using T = typename Entry::first_type;
-            return (self.index() == Entry::second_type::value) ?
-                       callable(self.get<T>()) :
-                       on_alternate<bijection<Next, Rest...>>::invoke(self, callable);
-        }
-    };
+    template <class Self, class Callable>
+    struct visit_result
+        : std::common_type<decltype(std::declval<Callable&>()(
+              std::declval<match_const_t<Self, unboxed_t<Ts>>&>()))...> {};
 
-    inline auto
-    destroy_internal() noexcept(stdx::disjunction<std::is_nothrow_destructible<Ts>...>::value)
-        -> void {
-        return on_alternate<alternative_index_map>::invoke(*this, [](auto&& s) {
-            using T = std::decay_t<decltype(s)>;
-            s.T::~T();
-        });
+    template <class Self, class Callable>
+    using visit_result_t = typename visit_result<Self, Callable>::type;
+
+    using base_type::construct;
+    using base_type::destroy_internal;
+    using base_type::get_unchecked;
+
+    // Alternatives are dispatched with a table of function pointers indexed by `index()`, so the
+    // cost of `visit` does not depend on the number of alternatives.
+    template <class Self, class Callable>
+    static auto visit_impl(Self& self, Callable& callable) -> visit_result_t<Self, Callable> {
+        using result_type = visit_result_t<Self, Callable>;
+        using handler_type = result_type (*)(Self&, Callable&);
+
+        static constexpr handler_type handlers[] = {
+            &type::visit_alternative<result_type, Self, Callable, unboxed_t<Ts>>...};
+
+        return handlers[self.index() - 1](self, callable);
+    }
+
+    template <class R, class Self, class Callable, class T>
+    static auto visit_alternative(Self& self, Callable& callable) -> R {
+        return callable(self.template get_unchecked<T>());
     }
 
     template <class T, enable_if_key_t<T> = 0>
     inline auto get_impl() noexcept -> T* {
-        if (holds<T>()) {
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-            return reinterpret_cast<T*>(std::addressof(storage_));
-        }
-        return nullptr;
+        return holds<T>() ? std::addressof(this->template get_unchecked<T>()) : nullptr;
     }
 
-    storage_type storage_ = {};
-    index_type index_ = alternative_index_map::template at_key<empty>::value;
+    template <class T, enable_if_key_t<T> = 0>
+    inline auto get_impl() const noexcept -> const T* {
+        return holds<T>() ? std::addressof(this->template get_unchecked<T>()) : nullptr;
+    }
 };
 
+template <class... Ts>
+using Variant = BasicVariant<separate_index, Ts...>;
+
+template <class... Ts>
+using PackedVariant = BasicVariant<packed_index, Ts...>;
+
+// Reports if the index of a `PackedVariant<Ts...>` is stored in the alternative storage, and the
+// resulting size.
+template <class... Ts>
+struct index_packing
+    : std::integral_constant<bool,
+                             detail::alternatives_layout<
+                                 typename detail::alternative_traits<Ts>::stored_type...>::
+                                 has_spare_tail_byte> {
+    static constexpr std::size_t size = sizeof(PackedVariant<Ts...>);
+};
+
+template <class T>
+struct is_variant : std::false_type {};
+
+template <class Layout, class... Ts>
+struct is_variant<BasicVariant<Layout, Ts...>> : std::true_type {};
+
+namespace detail {
+
+template <class V, std::size_t I>
+using alternative_t = typename std::decay_t<V>::alternative_index_map::template at_value<
+    aux::index_constant<I + 1>>;
+
+template <class V, std::size_t I>
+using qualified_alternative_t =
+    std::conditional_t<std::is_const<V>::value, const alternative_t<V, I>, alternative_t<V, I>>;
+
+template <class Callable, class V1, class V2, std::size_t K>
+using visit2_alternative_result_t = decltype(std::declval<Callable&>()(
+    std::declval<qualified_alternative_t<V1, K / std::decay_t<V2>::size>&>(),
+    std::declval<qualified_alternative_t<V2, K % std::decay_t<V2>::size>&>()));
+
+template <class R, class Callable, class V1, class V2, std::size_t K>
+auto visit2_alternative(Callable& callable, V1& v1, V2& v2) -> R {
+    constexpr auto n = std::decay_t<V2>::size;
+    return callable(access::get<alternative_t<V1, K / n>>(v1),
+                    access::get<alternative_t<V2, K % n>>(v2));
+}
+
+// Visit a pair of Variants with a single table of `V1::size * V2::size` function pointers,
+// indexed by the combined alternative index.
+template <class Callable, class V1, class V2, std::size_t... Ks>
+auto visit2(Callable& callable, V1& v1, V2& v2, std::index_sequence<Ks...>)
+    -> std::common_type_t<visit2_alternative_result_t<Callable, V1, V2, Ks>...> {
+    using result_type = std::common_type_t<visit2_alternative_result_t<Callable, V1, V2, Ks>...>;
+    using handler_type = result_type (*)(Callable&, V1&, V2&);
+
+    static constexpr handler_type handlers[] = {
+        &visit2_alternative<result_type, Callable, V1, V2, Ks>...};
+
+    const auto i = static_cast<std::size_t>(v1.index() - 1);
+    const auto j = static_cast<std::size_t>(v2.index() - 1);
+    return handlers[(i * std::decay_t<V2>::size) + j](callable, v1, v2);
+}
+
+} // namespace detail
+
+// Invoke `callable` with the alternatives currently held by `v1` and `v2`. This may be used to
+// inspect the states of two machines at once. Throws `bad_variant_access` if either Variant is
+// empty.
+template <class Callable,
+          class V1,
+          class V2,
+          std::enable_if_t<is_variant<std::remove_const_t<V1>>::value &&
+                               is_variant<std::remove_const_t<V2>>::value,
+                           int> = 0>
+auto visit(Callable callable, V1& v1, V2& v2) {
+    static_assert((V1::size > 0) && (V2::size > 0),
+                  "`visit` cannot be called if Variant is not defined with any alternatives.");
+
+    if ((v1.index() == 0) || (v2.index() == 0)) {
+        error::raise(bad_variant_access{});
+    }
+
+    return detail::visit2(callable, v1, v2, std::make_index_sequence<V1::size * V2::size>{});
+}
+
 } // namespace variant
 } // namespace state_machine
@@ -0,0 +1,26 @@
+#include "state_machine.h"
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+using ::state_machine::transition::make_table_from_transition_args;
+
+struct s1 {};
+struct s2 {};
+struct e1 {};
+
+auto generate_table() {
+    return make_table_from_transition_args(
+        state<s1>, event<e1>, _, [](e1&) { return s2{}; }, state<s2>);
+}
+} // namespace
+
+int main() {
+    ::state_machine::StateMachine<decltype(generate_table())> sm{generate_table()};
+
+    // The action takes `e1&`, so a const event cannot be passed to it.
+    const auto e = e1{};
+    sm.process_event(e);
+    return 0;
+}
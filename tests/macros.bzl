@@ -1,16 +1,17 @@
 load("@local_config//:variables.bzl", "STATE_MACHINE_DEFAULT_COPTS")
 
-def add_unit_test(name, **kwargs):
+def add_unit_test(name, src = None, copts = [], **kwargs):
     """Add a unit test with default options.
 
     This macro assumes the unit test requires a single source file which is
-    derived from the `name` argument.
+    derived from the `name` argument, unless `src` is given. `copts` are added
+    to the default options.
     """
     native.cc_test(
         name = name,
         size = "small",
-        srcs = [name + ".cc"],
-        copts = STATE_MACHINE_DEFAULT_COPTS,
+        srcs = [src or name + ".cc"],
+        copts = STATE_MACHINE_DEFAULT_COPTS + copts,
         deps = [
             "@googletest//:gtest_main",
             "//:state_machine",
@@ -0,0 +1,243 @@
+#include "state_machine.h"
+#include "state_machine/bulk_ingest.h"
+#include "state_machine/transition/transition_table.h"
+#include "state_machine/variant.h"
+
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::state_machine::BulkIngest;
+using ::state_machine::state_machine::process_status;
+using ::state_machine::transition::make_table_from_transition_args;
+using ::state_machine::variant::Variant;
+
+struct idle {};
+
+struct active {
+    std::vector<uint32_t> sequence;
+};
+
+struct message {
+    uint32_t sequence;
+};
+
+struct start {
+    auto operator()(const message& m) const -> active { return active{{m.sequence}}; }
+};
+
+struct record {
+    auto operator()(active& a, const message& m) const -> void { a.sequence.push_back(m.sequence); }
+};
+
+// Messages with an even sequence number are rejected in `idle`.
+struct odd {
+    auto operator()(const message& m) const -> bool { return m.sequence % 2 == 1; }
+};
+
+auto generate_table() {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<idle>,   event<message>, odd{}, start{},  state<active>,
+        state<active>, event<message>, _,     record{}, _);
+    // clang-format on
+}
+
+using machine_type = decltype(::state_machine::make_state_machine(generate_table()));
+
+auto make_machines(size_t count) -> std::vector<machine_type> {
+    std::vector<machine_type> machines;
+    machines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        machines.emplace_back(generate_table());
+    }
+    return machines;
+}
+
+} // namespace
+
+TEST(bulk_ingest, process_events) {
+    // More machines than buckets in one digit, so the keys are sorted in two passes.
+    constexpr size_t num_machines = 5000;
+    constexpr size_t num_events = 20000;
+
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<uint32_t> key_distribution{0, num_machines - 1};
+
+    std::vector<uint32_t> keys;
+    std::vector<message> events;
+    for (uint32_t i = 0; i < num_events; ++i) {
+        keys.push_back(key_distribution(rng));
+        events.push_back(message{i});
+    }
+
+    auto expected_machines = make_machines(num_machines);
+    std::vector<process_status> expected(num_events);
+    for (size_t i = 0; i < num_events; ++i) {
+        expected[i] = expected_machines[keys[i]].process_event(events[i]);
+    }
+
+    auto machines = make_machines(num_machines);
+    std::vector<process_status> statuses(num_events);
+    BulkIngest<> ingest;
+    ingest.process_events(machines, keys.data(), events.data(), num_events, statuses.data());
+
+    EXPECT_EQ(expected, statuses);
+    for (size_t k = 0; k < num_machines; ++k) {
+        ASSERT_EQ(expected_machines[k].is_state<active>(), machines[k].is_state<active>());
+        if (machines[k].is_state<active>()) {
+            // Each machine received its events in arrival order.
+            const auto& a = machines[k].current_state().get<active>();
+            const auto& e = expected_machines[k].current_state().get<active>();
+            ASSERT_EQ(e.sequence, a.sequence);
+        }
+    }
+}
+
+TEST(bulk_ingest, invalid_keys) {
+    auto machines = make_machines(3);
+
+    const std::vector<uint16_t> keys = {2, 7, 0, 3, 2};
+    const std::vector<message> events = {
+        message{1}, message{3}, message{2}, message{5}, message{4}};
+    std::vector<process_status> statuses(keys.size());
+
+    BulkIngest<uint16_t> ingest;
+    ingest.process_events(machines, keys.data(), events.data(), keys.size(), statuses.data());
+
+    EXPECT_EQ((std::vector<process_status>{process_status::Completed,
+                                           process_status::InvalidState,
+                                           process_status::GuardFailure,
+                                           process_status::InvalidState,
+                                           process_status::Completed}),
+              statuses);
+    EXPECT_EQ((std::vector<uint32_t>{1, 4}),
+              machines[2].current_state().get<active>().sequence);
+
+    // The buffers are reused for the next batch.
+    ingest.process_events(machines, keys.data(), events.data(), 1, statuses.data());
+    EXPECT_EQ((std::vector<uint32_t>{1, 4, 1}),
+              machines[2].current_state().get<active>().sequence);
+}
+
+namespace {
+
+struct open_session {
+    uint32_t id;
+};
+
+// Consumed by the action, which takes the event by non-const reference.
+struct payload {
+    std::string bytes;
+};
+
+struct session {
+    uint32_t id;
+    std::string received;
+};
+
+struct closed {};
+
+struct open {
+    auto operator()(const open_session& o) const -> session { return session{o.id, {}}; }
+};
+
+struct consume {
+    auto operator()(session& s, payload& p) const -> void {
+        s.received += p.bytes;
+        p.bytes.clear();
+    }
+};
+
+struct to_closed {
+    constexpr to_closed() = default;
+    auto operator()() const -> closed { return {}; }
+};
+
+auto generate_session_table() {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<closed>,  event<open_session>, _, open{},      state<session>,
+        state<session>, event<payload>,      _, consume{},   _,
+        state<session>, event<closed>,       _, to_closed{}, state<closed>);
+    // clang-format on
+}
+
+using session_machine_type =
+    decltype(::state_machine::make_state_machine(generate_session_table()));
+
+auto make_session_machines(size_t count) -> std::vector<session_machine_type> {
+    std::vector<session_machine_type> machines;
+    machines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        machines.emplace_back(generate_session_table());
+    }
+    return machines;
+}
+
+} // namespace
+
+TEST(bulk_ingest, mixed_events) {
+    using event_type = Variant<open_session, payload, closed>;
+
+    auto machines = make_session_machines(2);
+    const std::vector<uint32_t> keys = {1, 0, 1, 0, 1};
+    std::vector<event_type> events(keys.size());
+    events[0].emplace<open_session>(open_session{1});
+    events[1].emplace<payload>(payload{"x"});
+    events[2].emplace<payload>(payload{"ab"});
+    events[3].emplace<open_session>(open_session{0});
+    events[4].emplace<closed>();
+    std::vector<process_status> statuses(keys.size());
+
+    BulkIngest<> ingest;
+    ingest.process_events(machines, keys.data(), events.data(), keys.size(), statuses.data());
+
+    EXPECT_EQ((std::vector<process_status>{process_status::Completed,
+                                           process_status::UndefinedTransition,
+                                           process_status::Completed,
+                                           process_status::Completed,
+                                           process_status::Completed}),
+              statuses);
+    EXPECT_TRUE(machines[0].is_state<session>());
+    EXPECT_TRUE(machines[1].is_state<closed>());
+
+    // The action consumed the payload it was given.
+    EXPECT_EQ("", events[2].get<payload>().bytes);
+    EXPECT_EQ("x", events[1].get<payload>().bytes);
+}
+
+TEST(bulk_ingest, process_event_ids) {
+    auto machines = make_machines(3);
+
+    // Messages received as an event index and a payload. Index 1 is not an event of the table.
+    const std::vector<uint16_t> keys = {2, 0, 5, 2};
+    const std::vector<size_t> ids = {0, 1, 0, 0};
+    const std::vector<message> messages = {message{1}, message{3}, message{5}, message{2}};
+    std::vector<const void*> payloads;
+    for (const auto& m : messages) {
+        payloads.push_back(&m);
+    }
+    std::vector<process_status> statuses(keys.size());
+
+    BulkIngest<uint16_t> ingest;
+    ingest.process_event_ids(
+        machines, keys.data(), ids.data(), payloads.data(), keys.size(), statuses.data());
+
+    EXPECT_EQ((std::vector<process_status>{process_status::Completed,
+                                           process_status::UndefinedTransition,
+                                           process_status::InvalidState,
+                                           process_status::Completed}),
+              statuses);
+    EXPECT_EQ((std::vector<uint32_t>{1, 2}),
+              machines[2].current_state().get<active>().sequence);
+    EXPECT_TRUE(machines[0].is_state<idle>());
+}
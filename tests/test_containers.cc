@@ -30,6 +30,10 @@ TEST(containers_op, contains) {
     static_assert(op::contains<A, list<A, B>>::value, "");
     static_assert(op::contains<A, list<A>>::value, "");
     static_assert(!op::contains<A, list<B>>::value, "");
+
+    // Nested lists are not searched.
+    static_assert(!op::contains<A, list<list<A>>>::value, "");
+    static_assert(op::contains<list<A>, list<list<A>>>::value, "");
 }
 
 TEST(containers_op, make_unique) {
@@ -74,6 +78,13 @@ TEST(containers_op, map) {
     static_assert(std::is_same<Expected, op::map<get_first, Input>>::value, "");
 }
 
+TEST(containers_op, size) {
+    static_assert(op::size<list<>>::value == 0, "");
+    static_assert(op::size<list<A>>::value == 1, "");
+    static_assert(op::size<list<A, B, A>>::value == 3, "");
+    static_assert(op::size<inheritor<A, B>>::value == 2, "");
+}
+
 namespace {
 
 using S0 = surjection<std::pair<std::integral_constant<int, 0>, std::integral_constant<int, 0>>,
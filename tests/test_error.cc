@@ -0,0 +1,82 @@
+// Errors are passed to the error handler in this test, as if exceptions were disabled. The
+// `test_error_no_exceptions` target builds it with `-fno-exceptions` instead, so that
+// `STATE_MACHINE_NO_EXCEPTIONS` is defined by `error.h` and the whole library is compiled without
+// exceptions.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define STATE_MACHINE_NO_EXCEPTIONS
+#endif
+
+#include "state_machine.h"
+#include "state_machine/error.h"
+#include "state_machine/variant.h"
+
+#ifndef STATE_MACHINE_NO_EXCEPTIONS
+#error "`STATE_MACHINE_NO_EXCEPTIONS` must be defined in this test."
+#endif
+
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <exception>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::MachinePool;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+using ::state_machine::transition::make_table_from_transition_args;
+using ::state_machine::variant::Variant;
+
+struct s1 {
+    int value;
+};
+struct s2 {};
+
+auto report(const std::exception&) -> void {
+    std::fputs("state_machine error\n", stderr);
+}
+
+class ErrorTest : public ::testing::Test {
+  protected:
+    void SetUp() override { previous_ = ::state_machine::error::set_handler(&report); }
+    void TearDown() override { ::state_machine::error::set_handler(previous_); }
+
+  private:
+    ::state_machine::error::handler previous_ = nullptr;
+};
+
+} // namespace
+
+TEST_F(ErrorTest, set_handler) {
+    EXPECT_EQ(::state_machine::error::get_handler(), &report);
+    EXPECT_EQ(::state_machine::error::set_handler(nullptr), &report);
+    EXPECT_EQ(::state_machine::error::get_handler(), nullptr);
+    ::state_machine::error::set_handler(&report);
+}
+
+TEST_F(ErrorTest, bad_variant_access_calls_handler) {
+    auto v = Variant<s1, s2>{};
+    v.set(s1{1});
+
+    EXPECT_EQ(v.get<s1>().value, 1);
+    EXPECT_DEATH(v.get<s2>(), "state_machine error");
+}
+
+TEST_F(ErrorTest, aborts_without_handler) {
+    ::state_machine::error::set_handler(nullptr);
+
+    auto v = Variant<s1, s2>{};
+    EXPECT_DEATH(v.get<s1>(), "");
+}
+
+TEST_F(ErrorTest, machine_pool_get_calls_handler) {
+    const auto generate_table = []() {
+        return make_table_from_transition_args(
+            state<s2>, event<s1>, _, [](const s1&) { return s1{0}; }, state<s1>);
+    };
+
+    MachinePool<decltype(generate_table())> pool{generate_table()};
+    const auto h = pool.create();
+
+    EXPECT_TRUE(pool.is_state<s2>(h));
+    EXPECT_DEATH(pool.get<s1>(h), "state_machine error");
+}
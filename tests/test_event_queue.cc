@@ -0,0 +1,129 @@
+#include "state_machine.h"
+#include "state_machine/event_queue.h"
+#include "state_machine/transition/transition_table.h"
+
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::process_status;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::state_machine::EventQueue;
+using ::state_machine::transition::make_table_from_transition_args;
+
+struct counting {
+    uint64_t count = 0;
+    bool in_order = true;
+};
+
+struct closed {};
+
+struct tick {
+    uint64_t sequence;
+};
+struct hangup {};
+
+struct record {
+    auto operator()(counting& c, const tick& t) const -> void {
+        c.in_order = c.in_order && (t.sequence == c.count);
+        ++c.count;
+    }
+};
+
+struct to_closed {
+    constexpr to_closed() = default;
+    auto operator()() const -> closed { return {}; }
+};
+
+auto generate_table() {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<counting>, event<tick>,   _, record{},    _,
+        state<counting>, event<hangup>, _, to_closed{}, state<closed>);
+    // clang-format on
+}
+
+using queue_type = EventQueue<decltype(generate_table())>;
+
+} // namespace
+
+TEST(event_queue, drain) {
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    queue_type queue{8};
+    EXPECT_EQ(8, queue.capacity());
+    EXPECT_TRUE(queue.empty());
+
+    for (uint64_t n = 0; n < 8; ++n) {
+        EXPECT_TRUE(queue.try_push(tick{n}));
+    }
+    EXPECT_FALSE(queue.try_push(tick{8}));
+
+    // Draining stops at the budget.
+    EXPECT_EQ(3, queue.drain(machine, 3));
+    EXPECT_EQ(3, machine.current_state().get<counting>().count);
+
+    EXPECT_EQ(5, queue.drain(machine));
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(0, queue.drain(machine));
+
+    const auto& c = machine.current_state().get<counting>();
+    EXPECT_EQ(8, c.count);
+    EXPECT_TRUE(c.in_order);
+}
+
+TEST(event_queue, statuses) {
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    queue_type queue{4};
+
+    EXPECT_TRUE(queue.try_push(tick{0}));
+    EXPECT_TRUE(queue.try_push(hangup{}));
+    EXPECT_TRUE(queue.try_push(tick{1}));
+
+    std::vector<process_status> statuses;
+    EXPECT_EQ(3, queue.drain(machine, 10, [&statuses](process_status s) {
+        statuses.push_back(s);
+    }));
+
+    const std::vector<process_status> expected = {process_status::Completed,
+                                                  process_status::Completed,
+                                                  process_status::UndefinedTransition};
+    EXPECT_EQ(expected, statuses);
+    EXPECT_TRUE(machine.is_state<closed>());
+}
+
+TEST(event_queue, threads) {
+    constexpr uint64_t num_events = 100000;
+
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    queue_type queue{64};
+
+    std::thread producer{[&queue] {
+        for (uint64_t n = 0; n < num_events; ++n) {
+            while (!queue.try_push(tick{n})) {
+                std::this_thread::yield();
+            }
+        }
+    }};
+
+    uint64_t processed = 0;
+    while (processed < num_events) {
+        const auto count = queue.drain(machine, 100);
+        EXPECT_LE(count, 100);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        processed += count;
+    }
+    producer.join();
+
+    const auto& c = machine.current_state().get<counting>();
+    EXPECT_EQ(num_events, c.count);
+    EXPECT_TRUE(c.in_order);
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,208 @@
+#include "state_machine.h"
+#include "state_machine/lookup_batch.h"
+#include "state_machine/lookup_state_machine.h"
+#include "state_machine/transition/transition_table.h"
+
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::state_machine::LookupBatch;
+using ::state_machine::state_machine::LookupStateMachine;
+using ::state_machine::transition::make_row;
+using ::state_machine::transition::make_table;
+using ::state_machine::transition::make_table_from_transition_args;
+using ::state_machine::transition::make_transition;
+
+struct s1 {};
+struct s2 {};
+struct s3 {};
+
+struct e1 {};
+struct e2 {};
+struct e3 {};
+
+template <class State>
+struct to {
+    constexpr to() = default;
+    constexpr auto operator()() const noexcept -> State { return {}; }
+};
+
+int guard_count = 0;
+
+struct counting_guard {
+    auto operator()() const noexcept -> bool {
+        ++guard_count;
+        return true;
+    }
+};
+
+constexpr auto generate_table() noexcept {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<s1>, event<e1>,                _,   to<s2>{}, state<s2>,
+        state<s2>, event<e1>,                _,   to<s3>{}, state<s3>,
+        state<s3>, event<e1>,                _,   to<s1>{}, state<s1>,
+        state<s1>, event<e2>,                _,          _,         _,
+        state<s2>, event<e2>,                _,   to<s1>{}, state<s1>,
+        state<s3>, event<e3>, counting_guard{},   to<s1>{}, state<s1>);
+    // clang-format on
+}
+
+constexpr auto table = generate_table();
+
+using static_table_type = ::state_machine::static_table<decltype(table), table>;
+using batch_type = LookupBatch<static_table_type>;
+using machine_type = LookupStateMachine<static_table_type>;
+
+template <size_t N>
+struct sn {};
+
+// A ring of `sizeof...(Is)` states, advanced by `e1`.
+template <size_t... Is>
+constexpr auto generate_ring_table(std::index_sequence<Is...>) noexcept {
+    constexpr auto n = sizeof...(Is);
+    return make_table(make_row(make_transition(
+        state<sn<Is>>, event<e1>, _, to<sn<(Is + 1) % n>>{}, state<sn<(Is + 1) % n>>))...);
+}
+
+// Machines in states cycling through s1, s2, s3, so every state is covered in every vector.
+auto make_states(size_t count) -> std::vector<uint8_t> {
+    std::vector<uint8_t> states(count);
+    for (size_t i = 0; i < count; ++i) {
+        states[i] = static_cast<uint8_t>(i % 3);
+    }
+    return states;
+}
+
+template <class Event>
+auto step_machines(const std::vector<uint8_t>& states, const Event& e) -> std::vector<uint8_t> {
+    std::vector<uint8_t> result;
+    for (auto s : states) {
+        machine_type sm{};
+        // Drive the machine to state `s` with `e1`, which cycles through all states.
+        while (sm.state_index() != s) {
+            sm.process_event(e1{});
+        }
+        sm.process_event(e);
+        result.push_back(static_cast<uint8_t>(sm.state_index()));
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(lookup_batch, is_lookup_only) {
+    static_assert(batch_type::is_lookup_only<e1>::value, "");
+    static_assert(batch_type::is_lookup_only<e2>::value, "");
+    static_assert(!batch_type::is_lookup_only<e3>::value, "");
+}
+
+TEST(lookup_batch, start) {
+    const batch_type batch{};
+    std::vector<uint8_t> states(5, 2);
+
+    batch.start(states.data(), states.size());
+    EXPECT_EQ(std::vector<uint8_t>(5, 0), states);
+}
+
+TEST(lookup_batch, process_event) {
+    const batch_type batch{};
+
+    // Sizes covering whole vectors and remainders.
+    for (auto count : {size_t{1}, size_t{15}, size_t{16}, size_t{33}, size_t{100}}) {
+        auto states = make_states(count);
+        const auto expected_e1 = step_machines(states, e1{});
+        batch.process_event(states.data(), states.size(), e1{});
+        EXPECT_EQ(expected_e1, states);
+
+        const auto expected_e2 = step_machines(states, e2{});
+        batch.process_event(states.data(), states.size(), e2{});
+        EXPECT_EQ(expected_e2, states);
+    }
+}
+
+TEST(lookup_batch, process_event_scalar) {
+    const batch_type batch{};
+    auto states = make_states(40);
+    const auto expected = step_machines(states, e3{});
+
+    guard_count = 0;
+    batch.process_event(states.data(), states.size(), e3{});
+    EXPECT_EQ(expected, states);
+
+    // The guard is called for each machine in `s3`.
+    EXPECT_EQ(13, guard_count);
+}
+
+TEST(lookup_batch, process_event_ids) {
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<s1>, event<e1>, _, to<s2>{}, state<s2>,
+            state<s2>, event<e1>, _, to<s3>{}, state<s3>,
+            state<s3>, event<e1>, _, to<s1>{}, state<s1>,
+            state<s2>, event<e2>, _, to<s1>{}, state<s1>,
+            state<s3>, event<e2>, _, to<s3>{}, state<s3>);
+        // clang-format on
+    };
+
+    LookupBatch<decltype(generate_table())> batch{generate_table()};
+
+    std::vector<uint8_t> states;
+    std::vector<uint8_t> events;
+    std::vector<uint8_t> expected;
+    for (size_t i = 0; i < 27; ++i) {
+        const auto s = static_cast<uint8_t>(i % 3);
+        const auto e = static_cast<uint8_t>(((i % 4) == 3) ? (255 - i) : ((i / 3) % 2));
+        states.push_back(s);
+        events.push_back(e);
+
+        // e1 cycles through the states, e2 returns from s2 to s1, other indices are ignored.
+        if (e > 1) {
+            expected.push_back(s);
+        } else {
+            expected.push_back(
+                static_cast<uint8_t>((e == 0) ? ((s + 1) % 3) : ((s == 1) ? 0 : s)));
+        }
+    }
+
+    batch.process_event_ids(states.data(), events.data(), states.size());
+    EXPECT_EQ(expected, states);
+}
+
+TEST(lookup_batch, process_event_ids_scalar) {
+    const batch_type batch{};
+
+    std::vector<uint8_t> states = {0, 1, 2, 2, 0};
+    const std::vector<uint8_t> events = {0, 1, 2, 0, 9};
+
+    guard_count = 0;
+    batch.process_event_ids(states.data(), events.data(), states.size());
+    EXPECT_EQ((std::vector<uint8_t>{1, 0, 0, 0, 0}), states);
+    EXPECT_EQ(1, guard_count);
+}
+
+TEST(lookup_batch, process_event_large_table) {
+    constexpr size_t num_states = 20;
+    using table_type = decltype(generate_ring_table(std::make_index_sequence<num_states>{}));
+
+    LookupBatch<table_type> batch{generate_ring_table(std::make_index_sequence<num_states>{})};
+
+    std::vector<uint8_t> states;
+    for (size_t i = 0; i < 45; ++i) {
+        states.push_back(static_cast<uint8_t>(i % num_states));
+    }
+
+    batch.process_event(states.data(), states.size(), e1{});
+    for (size_t i = 0; i < states.size(); ++i) {
+        EXPECT_EQ((i + 1) % num_states, states[i]);
+    }
+}
@@ -0,0 +1,234 @@
+#include "state_machine.h"
+#include "state_machine/lookup_state_machine.h"
+#include "state_machine/transition/transition_table.h"
+
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::state_machine::is_payload_free;
+using ::state_machine::state_machine::LookupStateMachine;
+using ::state_machine::state_machine::make_lookup_state_machine;
+using ::state_machine::state_machine::process_status;
+using ::state_machine::transition::make_table_from_transition_args;
+
+struct s1 {};
+struct s2 {};
+struct s3 {};
+
+struct e1 {};
+struct e2 {};
+struct e3 {
+    // Events processed by index must be default constructible.
+    e3() = default;
+    constexpr explicit e3(int x) : value{x} {}
+    int value;
+};
+
+struct return_s2 {
+    constexpr return_s2() = default;
+    constexpr auto operator()() const noexcept -> s2 { return {}; }
+};
+
+struct return_s3 {
+    constexpr return_s3() = default;
+    constexpr auto operator()() const noexcept -> s3 { return {}; }
+};
+
+struct never {
+    constexpr never() = default;
+    constexpr auto operator()() const noexcept -> bool { return false; }
+};
+
+template <int N>
+struct e3_greater_than {
+    constexpr e3_greater_than() = default;
+    constexpr auto operator()(const e3& e) const noexcept -> bool { return e.value > N; }
+};
+
+int action_count = 0;
+
+struct count_s1 {
+    auto operator()() const noexcept -> s1 {
+        ++action_count;
+        return {};
+    }
+};
+
+constexpr auto generate_table() noexcept {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<s1>, event<e1>,                    _,           _,         _,
+        state<s1>, event<e2>,              never{}, return_s3{}, state<s3>,
+        state<s1>, event<e2>,                    _, return_s2{}, state<s2>,
+        state<s1>, event<e3>, e3_greater_than<0>{}, return_s3{}, state<s3>,
+        state<s2>, event<e2>,              never{}, return_s3{}, state<s3>,
+        state<s3>, event<e1>,                    _,  count_s1{}, state<s1>);
+    // clang-format on
+}
+
+constexpr auto table = generate_table();
+
+using static_table_type = ::state_machine::static_table<decltype(table), table>;
+
+} // namespace
+
+TEST(lookup_state_machine, is_payload_free) {
+    struct with_data {
+        int value;
+    };
+
+    static_assert(is_payload_free<decltype(generate_table())>::value, "");
+    static_assert(is_payload_free<static_table_type>::value, "");
+    static_assert(!is_payload_free<decltype(make_table_from_transition_args(
+                      state<with_data>, event<e1>, _, _, _))>::value,
+                  "");
+}
+
+TEST(lookup_state_machine, size) {
+    using sm_type = LookupStateMachine<static_table_type>;
+
+    static_assert(sizeof(sm_type) == sizeof(uint8_t), "");
+    static_assert(std::is_same<sm_type::state_index_type, uint8_t>::value, "");
+}
+
+TEST(lookup_state_machine, process_event) {
+    auto sm = make_lookup_state_machine(generate_table());
+    ASSERT_TRUE(sm.is_state<s1>());
+
+    EXPECT_EQ(process_status::EventIgnored, sm.process_event(e1{}));
+    EXPECT_TRUE(sm.is_state<s1>());
+
+    EXPECT_EQ(process_status::GuardFailure, sm.process_event(e3{0}));
+    EXPECT_TRUE(sm.is_state<s1>());
+
+    // The first guard for `e2` is `never`, folded into the table.
+    EXPECT_EQ(process_status::Completed, sm.process_event(e2{}));
+    EXPECT_TRUE(sm.is_state<s2>());
+
+    EXPECT_EQ(process_status::GuardFailure, sm.process_event(e2{}));
+    EXPECT_EQ(process_status::UndefinedTransition, sm.process_event(e1{}));
+    EXPECT_TRUE(sm.is_state<s2>());
+}
+
+TEST(lookup_state_machine, process_event_dynamic) {
+    action_count = 0;
+
+    LookupStateMachine<static_table_type> sm{};
+    ASSERT_TRUE(sm.is_state<s1>());
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(e3{1}));
+    EXPECT_TRUE(sm.is_state<s3>());
+
+    // `count_s1` is not a constant expression, so it is called.
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    EXPECT_TRUE(sm.is_state<s1>());
+    EXPECT_EQ(1, action_count);
+}
+
+TEST(lookup_state_machine, process_event_id) {
+    using sm_type = LookupStateMachine<static_table_type>;
+
+    std::vector<sm_type> machines(2);
+
+    const auto payload = e2{};
+    EXPECT_EQ(process_status::Completed,
+              machines[0].process_event_id(sm_type::event_index<e2>(), &payload));
+    EXPECT_TRUE(machines[0].is_state<s2>());
+    EXPECT_TRUE(machines[1].is_state<s1>());
+
+    EXPECT_EQ(process_status::UndefinedTransition, machines[1].process_event_id(3, nullptr));
+}
+
+TEST(lookup_state_machine, on_entry_on_exit) {
+    static int on_entry_count;
+    static int on_exit_count;
+
+    struct s4 {
+        // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+        auto on_entry() -> void { on_entry_count++; }
+        // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+        auto on_exit() -> void { on_exit_count++; }
+    };
+
+    struct return_s4 {
+        constexpr auto operator()() const noexcept -> s4 { return {}; }
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<s4>, event<e1>, _, return_s2{}, state<s2>,
+            state<s4>, event<e2>, _,           _,           _,
+            state<s2>, event<e1>, _, return_s4{}, state<s4>);
+        // clang-format on
+    };
+
+    {
+        LookupStateMachine<decltype(generate_table())> sm{generate_table()};
+        EXPECT_EQ(1, on_entry_count);
+        EXPECT_EQ(0, on_exit_count);
+
+        // Internal transitions do not leave the state.
+        EXPECT_EQ(process_status::EventIgnored, sm.process_event(e2{}));
+        EXPECT_EQ(0, on_exit_count);
+
+        EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+        EXPECT_TRUE(sm.is_state<s2>());
+        EXPECT_EQ(1, on_exit_count);
+
+        EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+        EXPECT_TRUE(sm.is_state<s4>());
+        EXPECT_EQ(2, on_entry_count);
+    }
+    EXPECT_EQ(2, on_exit_count);
+}
+
+namespace {
+
+int on_exit_move_count = 0;
+
+struct s5 {
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    auto on_exit() -> void { on_exit_move_count++; }
+};
+
+constexpr auto on_exit_table =
+    make_table_from_transition_args(state<s5>, event<e1>, _, return_s2{}, state<s2>);
+
+} // namespace
+
+TEST(lookup_state_machine, on_exit_move) {
+    using SM =
+        LookupStateMachine<::state_machine::static_table<decltype(on_exit_table), on_exit_table>>;
+
+    {
+        SM sm{};
+        SM other{std::move(sm)};
+
+        // The moved-from machine holds no state, so `on_exit` is only called by `other`.
+        // NOLINTNEXTLINE(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+        EXPECT_FALSE(sm.is_state<s5>());
+        // NOLINTNEXTLINE(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+        EXPECT_EQ(process_status::InvalidState, sm.process_event(e1{}));
+        EXPECT_TRUE(other.is_state<s5>());
+    }
+    EXPECT_EQ(1, on_exit_move_count);
+
+    {
+        SM sm{};
+        SM other{};
+
+        // Assigning exits the state of `other`, which is replaced.
+        other = std::move(sm);
+        EXPECT_EQ(2, on_exit_move_count);
+        EXPECT_TRUE(other.is_state<s5>());
+    }
+    EXPECT_EQ(3, on_exit_move_count);
+}
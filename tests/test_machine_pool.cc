@@ -0,0 +1,286 @@
+#include "state_machine.h"
+#include "state_machine/machine_pool.h"
+#include "state_machine/transition/transition_table.h"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::state_machine::MachinePool;
+using ::state_machine::state_machine::process_status;
+using ::state_machine::transition::emplace;
+using ::state_machine::transition::reuse;
+using ::state_machine::transition::make_table_from_transition_args;
+
+int exit_count = 0;
+
+struct idle {
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    auto on_exit() -> void { ++exit_count; }
+};
+
+struct receiving {
+    std::string buffer;
+};
+
+struct done {
+    std::string message;
+};
+
+struct data {
+    std::string bytes;
+};
+struct finish {};
+struct restart {};
+
+struct start_receiving {
+    auto operator()(const data& d) const -> receiving { return receiving{d.bytes}; }
+};
+
+struct append {
+    auto operator()(receiving& r, const data& d) const -> void { r.buffer += d.bytes; }
+};
+
+struct complete {
+    auto operator()(receiving& r) const { return emplace<done>(std::move(r.buffer)); }
+};
+
+struct non_empty {
+    auto operator()(const receiving& r) const -> bool { return !r.buffer.empty(); }
+};
+
+struct to_idle {
+    constexpr to_idle() = default;
+    auto operator()() const -> idle { return {}; }
+};
+
+auto generate_table() {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<idle>,      event<data>,    _,           start_receiving{}, state<receiving>,
+        state<receiving>, event<data>,    _,           append{},          _,
+        state<receiving>, event<finish>,  non_empty{}, complete{},        state<done>,
+        state<done>,      event<restart>, _,           to_idle{},         state<idle>);
+    // clang-format on
+}
+
+using pool_type = MachinePool<decltype(generate_table())>;
+
+constexpr auto restart_table =
+    make_table_from_transition_args(state<idle>, event<restart>, _, to_idle{}, state<idle>);
+
+} // namespace
+
+TEST(machine_pool, create_destroy) {
+    exit_count = 0;
+    pool_type pool{generate_table()};
+
+    const auto a = pool.create();
+    const auto b = pool.create();
+    EXPECT_NE(a, b);
+    EXPECT_EQ(2, pool.size());
+    EXPECT_EQ(2, pool.count<idle>());
+    EXPECT_TRUE(pool.is_state<idle>(a));
+
+    pool.destroy(a);
+    EXPECT_FALSE(pool.contains(a));
+    EXPECT_EQ(1, pool.size());
+    EXPECT_EQ(1, exit_count);
+    EXPECT_EQ(process_status::InvalidState, pool.process_event(a, restart{}));
+
+    // The slot of `a` is reused with a new generation, so `a` stays invalid.
+    const auto c = pool.create();
+    EXPECT_NE(a, c);
+    EXPECT_EQ(static_cast<uint32_t>(a), static_cast<uint32_t>(c));
+    EXPECT_FALSE(pool.contains(a));
+    EXPECT_TRUE(pool.contains(c));
+    EXPECT_EQ(0, pool.state_index(a));
+    EXPECT_EQ(process_status::InvalidState, pool.process_event(a, data{"a"}));
+    EXPECT_TRUE(pool.is_state<idle>(c));
+
+    pool.destroy(a);
+    EXPECT_TRUE(pool.contains(c));
+    EXPECT_EQ(2, pool.size());
+}
+
+TEST(machine_pool, create_throws) {
+    struct fragile {
+        explicit fragile(bool fail) {
+            if (fail) {
+                throw std::runtime_error{"fragile"};
+            }
+        }
+    };
+
+    const auto generate_table = []() {
+        return make_table_from_transition_args(
+            state<fragile>, event<restart>, _, []() { return fragile{false}; }, state<fragile>);
+    };
+
+    MachinePool<decltype(generate_table())> pool{generate_table()};
+    EXPECT_THROW(pool.create(true), std::runtime_error);
+    EXPECT_EQ(0, pool.size());
+    EXPECT_EQ(0, pool.count<fragile>());
+
+    // The slot reserved for the failed machine is used by the next one.
+    const auto a = pool.create(false);
+    EXPECT_EQ(0, a);
+    EXPECT_EQ(1, pool.size());
+    EXPECT_TRUE(pool.is_state<fragile>(a));
+}
+
+TEST(machine_pool, create_many) {
+    pool_type pool{generate_table()};
+
+    // The arrays grow geometrically, so creating machines one at a time reallocates them only a
+    // logarithmic number of times.
+    constexpr size_t count = 100000;
+    size_t reallocations = 0;
+    auto capacity = pool.handles<idle>().capacity();
+    for (size_t i = 0; i < count; ++i) {
+        pool.create();
+        if (pool.handles<idle>().capacity() != capacity) {
+            capacity = pool.handles<idle>().capacity();
+            ++reallocations;
+        }
+    }
+
+    EXPECT_EQ(count, pool.size());
+    EXPECT_EQ(count, pool.count<idle>());
+    EXPECT_GE(64, reallocations);
+}
+
+TEST(machine_pool, move_assign) {
+    exit_count = 0;
+    using static_pool_type =
+        MachinePool<::state_machine::static_table<decltype(restart_table), restart_table>>;
+
+    static_pool_type a{};
+    static_pool_type b{};
+    a.create();
+    b.create();
+    b.create();
+
+    // The machines replaced by the assignment exit their states.
+    b = std::move(a);
+    EXPECT_EQ(2, exit_count);
+    EXPECT_EQ(1, b.size());
+    EXPECT_TRUE(b.is_state<idle>(0));
+}
+
+TEST(machine_pool, process_event) {
+    pool_type pool{generate_table()};
+    const auto a = pool.create();
+    const auto b = pool.create();
+
+    EXPECT_EQ(process_status::Completed, pool.process_event(a, data{"ab"}));
+    EXPECT_TRUE(pool.is_state<receiving>(a));
+    EXPECT_TRUE(pool.is_state<idle>(b));
+
+    EXPECT_EQ(process_status::Completed, pool.process_event(a, data{"cd"}));
+    EXPECT_EQ("abcd", pool.get<receiving>(a).buffer);
+
+    EXPECT_EQ(process_status::UndefinedTransition, pool.process_event(b, finish{}));
+
+    EXPECT_EQ(process_status::Completed, pool.process_event(b, data{""}));
+    EXPECT_EQ(process_status::GuardFailure, pool.process_event(b, finish{}));
+
+    EXPECT_EQ(process_status::Completed, pool.process_event(a, finish{}));
+    EXPECT_TRUE(pool.is_state<done>(a));
+    EXPECT_EQ("abcd", pool.get<done>(a).message);
+
+    // `b` was moved within the array of `receiving` when `a` left it.
+    EXPECT_EQ(1, pool.count<receiving>());
+    EXPECT_EQ(b, pool.handles<receiving>().front());
+    EXPECT_TRUE(pool.get<receiving>(b).buffer.empty());
+}
+
+TEST(machine_pool, process_event_in) {
+    pool_type pool{generate_table()};
+
+    std::vector<pool_type::handle_type> handles;
+    for (size_t i = 0; i < 10; ++i) {
+        handles.push_back(pool.create());
+    }
+
+    // Move half of the machines to `receiving`.
+    for (size_t i = 0; i < handles.size(); i += 2) {
+        pool.process_event(handles[i], data{std::to_string(i)});
+    }
+    ASSERT_EQ(5, pool.count<idle>());
+    ASSERT_EQ(5, pool.count<receiving>());
+
+    // Only machines in `receiving` are processed, each exactly once.
+    EXPECT_EQ(5, pool.process_event_in<receiving>(data{"x"}));
+    pool.for_each<receiving>([&](pool_type::handle_type h, const receiving& r) {
+        const auto i = static_cast<size_t>(std::find(handles.begin(), handles.end(), h) -
+                                           handles.begin());
+        EXPECT_EQ(std::to_string(i) + "x", r.buffer);
+    });
+
+    EXPECT_EQ(5, pool.process_event_in<receiving>(finish{}));
+    EXPECT_EQ(0, pool.count<receiving>());
+    EXPECT_EQ(5, pool.count<done>());
+}
+
+TEST(machine_pool, process_event_all) {
+    pool_type pool{generate_table()};
+    for (size_t i = 0; i < 6; ++i) {
+        pool.create();
+    }
+    pool.process_event(0, data{"a"});
+
+    // Machines entering `receiving` from `idle` are not processed again.
+    EXPECT_EQ(6, pool.process_event_all(data{"b"}));
+    EXPECT_EQ(6, pool.count<receiving>());
+    EXPECT_EQ("ab", pool.get<receiving>(0).buffer);
+    EXPECT_EQ("b", pool.get<receiving>(1).buffer);
+}
+
+TEST(machine_pool, self_transition) {
+    const auto generate_table = []() {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<receiving>, event<data>,   _, [](const receiving& r, const data& d) {
+                return receiving{r.buffer + d.bytes};
+            }, state<receiving>,
+            state<receiving>, event<finish>, _, [](receiving& r) -> receiving& {
+                r.buffer += "!";
+                return r;
+            }, state<reuse<receiving>>);
+        // clang-format on
+    };
+
+    MachinePool<decltype(generate_table())> pool{generate_table()};
+    const auto a = pool.create();
+    const auto b = pool.create();
+    const auto c = pool.create();
+
+    // Without `reuse`, the destination is added to the array of the state before the source is
+    // removed from it.
+    EXPECT_EQ(process_status::Completed, pool.process_event(a, data{"a"}));
+    EXPECT_EQ(process_status::Completed, pool.process_event(b, data{"b"}));
+    EXPECT_EQ(process_status::Completed, pool.process_event(a, finish{}));
+
+    EXPECT_EQ(3, pool.count<receiving>());
+    EXPECT_EQ("a!", pool.get<receiving>(a).buffer);
+    EXPECT_EQ("b", pool.get<receiving>(b).buffer);
+    EXPECT_EQ("", pool.get<receiving>(c).buffer);
+}
+
+TEST(machine_pool, static_table) {
+    MachinePool<::state_machine::static_table<decltype(restart_table), restart_table>> pool{};
+    const auto h = pool.create();
+    EXPECT_EQ(process_status::Completed, pool.process_event(h, restart{}));
+    EXPECT_TRUE(pool.is_state<idle>(h));
+}
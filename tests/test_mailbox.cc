@@ -0,0 +1,242 @@
+#include "state_machine.h"
+#include "state_machine/mailbox.h"
+#include "state_machine/transition/transition_table.h"
+
+#include "gtest/gtest.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::Mailbox;
+using ::state_machine::overflow_policy;
+using ::state_machine::post_status;
+using ::state_machine::process_status;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::transition::make_table_from_transition_args;
+
+constexpr size_t num_producers = 3;
+
+struct counting {
+    uint64_t count = 0;
+    std::array<uint64_t, num_producers> next = {};
+    uint64_t first = 0;
+    bool in_order = true;
+};
+
+struct closed {};
+
+struct tick {
+    size_t producer;
+    uint64_t sequence;
+};
+struct hangup {};
+
+// Blocks the draining thread in an action until `resume` is set.
+struct hold {
+    std::atomic<bool>* paused;
+    std::atomic<bool>* resume;
+};
+
+// Events may be missing after a drop, but the remaining events of a producer must be in order.
+struct record {
+    auto operator()(counting& c, const tick& t) const -> void {
+        c.in_order = c.in_order && (t.sequence >= c.next[t.producer]);
+        c.next[t.producer] = t.sequence + 1;
+        if (c.count == 0) {
+            c.first = t.sequence;
+        }
+        ++c.count;
+    }
+};
+
+struct await {
+    auto operator()(counting&, const hold& p) const -> void {
+        p.paused->store(true);
+        while (!p.resume->load()) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+struct to_closed {
+    constexpr to_closed() = default;
+    auto operator()() const -> closed { return {}; }
+};
+
+auto generate_table() {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<counting>, event<tick>,   _, record{},    _,
+        state<counting>, event<hold>,   _, await{},     _,
+        state<counting>, event<hangup>, _, to_closed{}, state<closed>);
+    // clang-format on
+}
+
+using table_type = decltype(generate_table());
+
+// Post `events_per_producer` ticks from each producer thread while draining on this thread.
+// Returns the number of events processed.
+template <class M, class Machine>
+auto post_concurrently(M& mailbox, Machine& machine, uint64_t events_per_producer) -> uint64_t {
+    std::atomic<size_t> done{0};
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&mailbox, &done, p, events_per_producer] {
+            for (uint64_t n = 0; n < events_per_producer; ++n) {
+                mailbox.post(tick{p, n});
+            }
+            done.fetch_add(1);
+        });
+    }
+
+    uint64_t processed = 0;
+    while (done.load() < num_producers) {
+        const auto count = mailbox.drain(machine, 100);
+        EXPECT_LE(count, 100);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        processed += count;
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    return processed + mailbox.drain(machine);
+}
+
+} // namespace
+
+TEST(mailbox, block) {
+    constexpr uint64_t events_per_producer = 20000;
+
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    Mailbox<table_type> mailbox{16};
+    EXPECT_EQ(16, mailbox.capacity());
+
+    EXPECT_EQ(num_producers * events_per_producer,
+              post_concurrently(mailbox, machine, events_per_producer));
+    EXPECT_TRUE(mailbox.empty());
+    EXPECT_EQ(0, mailbox.dropped());
+
+    const auto& c = machine.current_state().get<counting>();
+    EXPECT_EQ(num_producers * events_per_producer, c.count);
+    EXPECT_TRUE(c.in_order);
+}
+
+TEST(mailbox, drop_oldest) {
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    Mailbox<table_type, overflow_policy::DropOldest> mailbox{4};
+
+    for (uint64_t n = 0; n < 4; ++n) {
+        EXPECT_EQ(post_status::Posted, mailbox.post(tick{0, n}));
+    }
+    EXPECT_EQ(post_status::DroppedOldest, mailbox.post(tick{0, 4}));
+    EXPECT_EQ(post_status::DroppedOldest, mailbox.post(tick{0, 5}));
+    EXPECT_EQ(2, mailbox.dropped());
+
+    EXPECT_EQ(4, mailbox.drain(machine));
+    const auto& c = machine.current_state().get<counting>();
+    EXPECT_EQ(4, c.count);
+    EXPECT_EQ(2, c.first);
+    EXPECT_TRUE(c.in_order);
+}
+
+TEST(mailbox, drop_oldest_concurrently) {
+    constexpr uint64_t events_per_producer = 20000;
+
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    Mailbox<table_type, overflow_policy::DropOldest> mailbox{8};
+
+    const auto processed = post_concurrently(mailbox, machine, events_per_producer);
+    EXPECT_EQ(num_producers * events_per_producer, processed + mailbox.dropped());
+
+    const auto& c = machine.current_state().get<counting>();
+    EXPECT_EQ(processed, c.count);
+    EXPECT_TRUE(c.in_order);
+}
+
+TEST(mailbox, drop_oldest_while_draining) {
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    Mailbox<table_type, overflow_policy::DropOldest> mailbox{8};
+
+    std::atomic<bool> paused{false};
+    std::atomic<bool> resume{false};
+    EXPECT_EQ(post_status::Posted, mailbox.post(hold{&paused, &resume}));
+    for (uint64_t n = 0; n < 7; ++n) {
+        EXPECT_EQ(post_status::Posted, mailbox.post(tick{0, n}));
+    }
+
+    // The slot of the paused event is freed before its action runs.
+    std::thread consumer{[&machine, &mailbox] { EXPECT_EQ(1, mailbox.drain(machine, 1)); }};
+    while (!paused.load()) {
+        std::this_thread::yield();
+    }
+
+    // Posts return while the consumer is held in the action, discarding the oldest queued event
+    // once the mailbox is full.
+    EXPECT_EQ(post_status::Posted, mailbox.post(tick{0, 7}));
+    EXPECT_EQ(post_status::DroppedOldest, mailbox.post(tick{0, 8}));
+    EXPECT_EQ(1, mailbox.dropped());
+    EXPECT_FALSE(resume.load());
+
+    resume.store(true);
+    consumer.join();
+
+    EXPECT_EQ(8, mailbox.drain(machine));
+    const auto& c = machine.current_state().get<counting>();
+    EXPECT_EQ(8, c.count);
+    EXPECT_EQ(1, c.first);
+    EXPECT_EQ(9, c.next[0]);
+    EXPECT_TRUE(c.in_order);
+}
+
+TEST(mailbox, drop_newest) {
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    Mailbox<table_type, overflow_policy::DropNewest> mailbox{4};
+
+    for (uint64_t n = 0; n < 4; ++n) {
+        EXPECT_EQ(post_status::Posted, mailbox.post(tick{0, n}));
+    }
+    EXPECT_EQ(post_status::DroppedNewest, mailbox.post(tick{0, 4}));
+    EXPECT_EQ(1, mailbox.dropped());
+
+    EXPECT_EQ(4, mailbox.drain(machine));
+    const auto& c = machine.current_state().get<counting>();
+    EXPECT_EQ(4, c.count);
+    EXPECT_EQ(0, c.first);
+    EXPECT_EQ(4, c.next[0]);
+}
+
+TEST(mailbox, reject) {
+    auto machine = ::state_machine::make_state_machine(generate_table());
+    Mailbox<table_type, overflow_policy::Reject> mailbox{2};
+
+    EXPECT_EQ(post_status::Posted, mailbox.post(tick{0, 0}));
+    EXPECT_EQ(post_status::Posted, mailbox.post(hangup{}));
+    EXPECT_EQ(post_status::Rejected, mailbox.post(tick{0, 1}));
+    EXPECT_EQ(0, mailbox.dropped());
+
+    std::vector<process_status> statuses;
+    EXPECT_EQ(2, mailbox.drain(machine, 10, [&statuses](process_status s) {
+        statuses.push_back(s);
+    }));
+    EXPECT_TRUE(machine.is_state<closed>());
+
+    // The rejected event may be posted again once there is room.
+    EXPECT_EQ(post_status::Posted, mailbox.post(tick{0, 1}));
+    EXPECT_EQ(1, mailbox.drain(machine, 10, [&statuses](process_status s) {
+        statuses.push_back(s);
+    }));
+
+    const std::vector<process_status> expected = {process_status::Completed,
+                                                  process_status::Completed,
+                                                  process_status::UndefinedTransition};
+    EXPECT_EQ(expected, statuses);
+}
@@ -0,0 +1,137 @@
+#include "state_machine/pmr.h"
+
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+using ::state_machine::pmr::memory_resource;
+using ::state_machine::pmr::monotonic_buffer_resource;
+using ::state_machine::pmr::polymorphic_allocator;
+
+// Forwards to the default resource and counts allocations.
+class counting_resource : public memory_resource {
+  public:
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+
+  private:
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override {
+        ++allocations;
+        return ::state_machine::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    auto do_deallocate(void* p, std::size_t bytes, std::size_t alignment) -> void override {
+        ++deallocations;
+        ::state_machine::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    auto do_is_equal(const memory_resource& other) const noexcept -> bool override {
+        return this == &other;
+    }
+};
+
+struct uses_leading {
+    using allocator_type = polymorphic_allocator<int>;
+
+    uses_leading(std::allocator_arg_t, const allocator_type& alloc, int v)
+        : resource{alloc.resource()}, value{v} {}
+
+    memory_resource* resource;
+    int value;
+};
+
+struct uses_trailing {
+    using allocator_type = polymorphic_allocator<int>;
+
+    uses_trailing(int v, const allocator_type& alloc) : resource{alloc.resource()}, value{v} {}
+
+    memory_resource* resource;
+    int value;
+};
+
+} // namespace
+
+TEST(pmr, default_resource) {
+    counting_resource upstream;
+
+    auto* previous = ::state_machine::pmr::set_default_resource(&upstream);
+    EXPECT_EQ(::state_machine::pmr::get_default_resource(), &upstream);
+    EXPECT_EQ(polymorphic_allocator<int>{}.resource(), &upstream);
+
+    ::state_machine::pmr::set_default_resource(previous);
+    EXPECT_EQ(::state_machine::pmr::get_default_resource(), previous);
+}
+
+TEST(pmr, monotonic_buffer_resource_initial_buffer) {
+    counting_resource upstream;
+    alignas(std::max_align_t) unsigned char buffer[256]; // NOLINT(modernize-avoid-c-arrays)
+
+    monotonic_buffer_resource resource{buffer, sizeof(buffer), &upstream};
+
+    auto* p = resource.allocate(64, alignof(std::max_align_t));
+    auto* q = resource.allocate(64, alignof(std::max_align_t));
+
+    EXPECT_NE(p, q);
+    EXPECT_EQ(upstream.allocations, 0U);
+
+    // Exhaust the initial buffer.
+    resource.allocate(256, 1);
+    EXPECT_EQ(upstream.allocations, 1U);
+
+    resource.release();
+    EXPECT_EQ(upstream.deallocations, 1U);
+    EXPECT_EQ(resource.allocate(64, alignof(std::max_align_t)), p);
+}
+
+TEST(pmr, monotonic_buffer_resource_alignment) {
+    monotonic_buffer_resource resource;
+
+    resource.allocate(1, 1);
+    auto* p = resource.allocate(sizeof(std::uint64_t), alignof(std::uint64_t));
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % alignof(std::uint64_t), 0U);
+}
+
+TEST(pmr, vector_uses_resource) {
+    counting_resource upstream;
+    monotonic_buffer_resource resource{&upstream};
+
+    {
+        auto v = std::vector<int, polymorphic_allocator<int>>{&resource};
+        for (auto i = 0; i < 100; ++i) {
+            v.push_back(i);
+        }
+        EXPECT_EQ(v.get_allocator().resource(), &resource);
+    }
+
+    EXPECT_GT(upstream.allocations, 0U);
+    EXPECT_EQ(upstream.deallocations, 0U);
+}
+
+TEST(pmr, allocator_equality) {
+    monotonic_buffer_resource r1;
+    monotonic_buffer_resource r2;
+
+    EXPECT_TRUE(polymorphic_allocator<int>{&r1} == polymorphic_allocator<char>{&r1});
+    EXPECT_TRUE(polymorphic_allocator<int>{&r1} != polymorphic_allocator<int>{&r2});
+}
+
+TEST(pmr, uses_allocator_construct) {
+    monotonic_buffer_resource resource;
+    auto alloc = polymorphic_allocator<int>{&resource};
+
+    auto* leading = polymorphic_allocator<uses_leading>{alloc}.allocate(1);
+    polymorphic_allocator<uses_leading>{alloc}.construct(leading, 1);
+    EXPECT_EQ(leading->resource, &resource);
+    EXPECT_EQ(leading->value, 1);
+
+    auto* trailing = polymorphic_allocator<uses_trailing>{alloc}.allocate(1);
+    polymorphic_allocator<uses_trailing>{alloc}.construct(trailing, 2);
+    EXPECT_EQ(trailing->resource, &resource);
+    EXPECT_EQ(trailing->value, 2);
+}
@@ -0,0 +1,184 @@
+#include "state_machine.h"
+#include "state_machine/session_map.h"
+#include "state_machine/transition/transition_table.h"
+
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::state_machine::process_status;
+using ::state_machine::state_machine::SessionMap;
+using ::state_machine::transition::make_table_from_transition_args;
+
+int closed_count = 0;
+
+struct idle {};
+
+struct open {
+    std::string buffer;
+};
+
+struct closed {
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    auto on_exit() -> void { ++closed_count; }
+};
+
+struct data {
+    std::string bytes;
+};
+struct hangup {};
+
+struct start {
+    auto operator()(const data& d) const -> open { return open{d.bytes}; }
+};
+
+struct append {
+    auto operator()(open& o, const data& d) const -> void { o.buffer += d.bytes; }
+};
+
+struct to_closed {
+    constexpr to_closed() = default;
+    auto operator()() const -> closed { return {}; }
+};
+
+auto generate_table() {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<idle>, event<data>,  _, start{},     state<open>,
+        state<open>, event<data>,  _, append{},    _,
+        state<open>, event<hangup>, _, to_closed{}, state<closed>);
+    // clang-format on
+}
+
+using table_type = decltype(generate_table());
+
+// All keys have the same hash, so every key collides.
+struct constant_hash {
+    auto operator()(uint64_t) const noexcept -> size_t { return 0; }
+};
+
+constexpr auto close_table =
+    make_table_from_transition_args(state<idle>, event<hangup>, _, to_closed{}, state<closed>);
+
+} // namespace
+
+TEST(session_map, process_event_creates) {
+    SessionMap<uint64_t, table_type> sessions{generate_table()};
+    EXPECT_TRUE(sessions.empty());
+    EXPECT_FALSE(sessions.contains(1));
+
+    EXPECT_EQ(process_status::UndefinedTransition, sessions.process_event(1, hangup{}));
+    EXPECT_TRUE(sessions.is_state<idle>(1));
+    EXPECT_EQ(1, sessions.size());
+
+    EXPECT_EQ(process_status::Completed, sessions.process_event(2, data{"a"}));
+    EXPECT_EQ(process_status::Completed, sessions.process_event(2, data{"b"}));
+    EXPECT_EQ("ab", sessions.get<open>(2).buffer);
+    EXPECT_EQ(2, sessions.size());
+    EXPECT_EQ(1, sessions.machines().count<open>());
+}
+
+TEST(session_map, erase) {
+    closed_count = 0;
+    SessionMap<uint64_t, table_type> sessions{generate_table()};
+    sessions.process_event(1, data{"a"});
+    sessions.process_event(1, hangup{});
+
+    // Without a terminal state, machines stay in the map.
+    EXPECT_TRUE(sessions.is_state<closed>(1));
+
+    EXPECT_TRUE(sessions.erase(1));
+    EXPECT_FALSE(sessions.erase(1));
+    EXPECT_FALSE(sessions.contains(1));
+    EXPECT_TRUE(sessions.empty());
+    EXPECT_EQ(1, closed_count);
+}
+
+TEST(session_map, terminal_state) {
+    closed_count = 0;
+    SessionMap<uint64_t, table_type, closed> sessions{generate_table()};
+
+    sessions.process_event(7, data{"a"});
+    EXPECT_EQ(process_status::Completed, sessions.process_event(7, hangup{}));
+    EXPECT_FALSE(sessions.contains(7));
+    EXPECT_EQ(0, sessions.machines().size());
+    EXPECT_EQ(1, closed_count);
+
+    // The key starts over in the initial state.
+    sessions.process_event(7, hangup{});
+    EXPECT_TRUE(sessions.is_state<idle>(7));
+}
+
+TEST(session_map, many_keys) {
+    SessionMap<uint64_t, table_type, closed> sessions{generate_table()};
+    constexpr uint64_t count = 1000;
+
+    for (uint64_t k = 0; k < count; ++k) {
+        sessions.process_event(k, data{std::to_string(k)});
+    }
+    EXPECT_EQ(count, sessions.size());
+
+    // Close every other session, leaving holes along the probe sequences.
+    for (uint64_t k = 0; k < count; k += 2) {
+        sessions.process_event(k, hangup{});
+    }
+    EXPECT_EQ(count / 2, sessions.size());
+
+    for (uint64_t k = 0; k < count; ++k) {
+        ASSERT_EQ(k % 2 == 1, sessions.contains(k));
+        if (k % 2 == 1) {
+            EXPECT_EQ(std::to_string(k), sessions.get<open>(k).buffer);
+        }
+    }
+}
+
+TEST(session_map, collisions) {
+    SessionMap<uint64_t, table_type, closed, constant_hash> sessions{generate_table()};
+    sessions.reserve(10);
+
+    for (uint64_t k = 0; k < 10; ++k) {
+        sessions.process_event(k, data{std::to_string(k)});
+    }
+
+    // Erasing from the middle of the probe sequence keeps later keys reachable.
+    sessions.process_event(3, hangup{});
+    sessions.process_event(0, hangup{});
+    for (uint64_t k = 0; k < 10; ++k) {
+        ASSERT_EQ(k != 0 && k != 3, sessions.contains(k));
+        if (k != 0 && k != 3) {
+            EXPECT_EQ(std::to_string(k), sessions.get<open>(k).buffer);
+        }
+    }
+}
+
+TEST(session_map, full_index_finds_existing_key) {
+    using ::state_machine::state_machine::detail::key_index;
+
+    // 16 slots hold at most 12 keys.
+    key_index<uint64_t, int, std::hash<uint64_t>> index{std::hash<uint64_t>{}};
+    index.reserve(12);
+    for (uint64_t k = 0; k < 12; ++k) {
+        index.find_or_insert(k, [k] { return static_cast<int>(k); });
+    }
+
+    // Finding a key of a full table does not grow it, so the value stays in place.
+    const auto* value = index.find(5);
+    EXPECT_EQ(value, &index.find_or_insert(5, [] { return -1; }));
+    EXPECT_EQ(5, *value);
+    EXPECT_EQ(12, index.size());
+}
+
+TEST(session_map, static_table) {
+    SessionMap<uint64_t, ::state_machine::static_table<decltype(close_table), close_table>, closed>
+        sessions{};
+    EXPECT_EQ(process_status::Completed, sessions.process_event(1, hangup{}));
+    EXPECT_TRUE(sessions.empty());
+}
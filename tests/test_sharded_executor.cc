@@ -0,0 +1,193 @@
+#include "state_machine.h"
+#include "state_machine/sharded_executor.h"
+#include "state_machine/transition/transition_table.h"
+
+#include "gtest/gtest.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+using ::state_machine::event;
+using ::state_machine::state;
+using ::state_machine::placeholder::_;
+
+using ::state_machine::state_machine::ShardedExecutor;
+using ::state_machine::transition::make_table_from_transition_args;
+
+constexpr size_t num_producers = 3;
+
+struct counting {
+    uint64_t count = 0;
+    std::array<uint64_t, num_producers> next = {};
+    bool in_order = true;
+};
+
+struct closed {};
+
+struct tick {
+    size_t producer;
+    uint64_t sequence;
+};
+struct hangup {};
+
+struct record {
+    auto operator()(counting& c, const tick& t) const -> void {
+        c.in_order = c.in_order && (t.sequence == c.next[t.producer]);
+        c.next[t.producer] = t.sequence + 1;
+        ++c.count;
+    }
+};
+
+struct to_closed {
+    constexpr to_closed() = default;
+    auto operator()() const -> closed { return {}; }
+};
+
+auto generate_table() {
+    // clang-format off
+    return make_table_from_transition_args(
+        state<counting>, event<tick>,   _, record{},    _,
+        state<counting>, event<hangup>, _, to_closed{}, state<closed>);
+    // clang-format on
+}
+
+using executor_type = ShardedExecutor<decltype(generate_table())>;
+
+constexpr auto close_table =
+    make_table_from_transition_args(state<counting>, event<hangup>, _, to_closed{}, state<closed>);
+
+} // namespace
+
+TEST(sharded_executor, process_events) {
+    constexpr uint64_t num_keys = 100;
+    constexpr uint64_t events_per_key = 200;
+
+    executor_type executor{generate_table(), 4, num_producers, 16};
+    executor.start();
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&executor, p] {
+            for (uint64_t n = 0; n < events_per_key; ++n) {
+                for (uint64_t k = 0; k < num_keys; ++k) {
+                    executor.post(p, k, tick{p, n});
+                }
+            }
+        });
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    executor.stop();
+
+    EXPECT_EQ(num_keys, executor.size());
+    for (uint64_t k = 0; k < num_keys; ++k) {
+        auto* machine = executor.find(k);
+        ASSERT_NE(nullptr, machine);
+
+        const auto& c = machine->current_state().get<counting>();
+        EXPECT_EQ(num_producers * events_per_key, c.count);
+        EXPECT_TRUE(c.in_order);
+    }
+
+    const auto processed = executor.processed();
+    EXPECT_EQ(4, processed.size());
+    EXPECT_EQ(num_producers * num_keys * events_per_key,
+              std::accumulate(processed.begin(), processed.end(), uint64_t{0}));
+}
+
+TEST(sharded_executor, try_post) {
+    executor_type executor{generate_table(), 1, 1, 4};
+    EXPECT_EQ(1, executor.num_shards());
+    EXPECT_EQ(1, executor.num_producers());
+
+    // Events are queued until the executor is started.
+    for (uint64_t n = 0; n < 4; ++n) {
+        EXPECT_TRUE(executor.try_post(0, 1, tick{0, n}));
+    }
+    EXPECT_FALSE(executor.try_post(0, 1, tick{0, 4}));
+    EXPECT_EQ(nullptr, executor.find(1));
+
+    executor.start(false);
+    executor.stop();
+    EXPECT_EQ(4, executor.find(1)->current_state().get<counting>().count);
+
+    // The executor can be restarted.
+    EXPECT_TRUE(executor.try_post(0, 1, hangup{}));
+    executor.start(false);
+    executor.stop();
+    EXPECT_TRUE(executor.find(1)->is_state<closed>());
+}
+
+TEST(sharded_executor, static_table) {
+    ShardedExecutor<::state_machine::static_table<decltype(close_table), close_table>> executor{
+        2, 1};
+    executor.start();
+    for (uint64_t k = 0; k < 10; ++k) {
+        executor.post(0, k, hangup{});
+    }
+    executor.stop();
+
+    EXPECT_EQ(10, executor.size());
+    for (uint64_t k = 0; k < 10; ++k) {
+        EXPECT_TRUE(executor.find(k)->is_state<closed>());
+    }
+}
+
+TEST(sharded_executor, rebalance) {
+    constexpr uint64_t events_per_key = 100;
+
+    executor_type executor{generate_table(), 2, 1, 8};
+
+    // Four keys homed on shard 0, so shard 1 is idle.
+    std::vector<uint64_t> keys;
+    for (uint64_t k = 0; keys.size() < 4; ++k) {
+        if (executor.shard_of(k) == 0) {
+            keys.push_back(k);
+        }
+    }
+
+    const auto post_events = [&executor, &keys](uint64_t first) {
+        for (uint64_t n = first; n < first + events_per_key; ++n) {
+            for (auto k : keys) {
+                executor.post(0, k, tick{0, n});
+            }
+        }
+    };
+    const auto wait_for = [](auto condition) {
+        while (!condition()) {
+            std::this_thread::yield();
+        }
+    };
+
+    executor.start(false);
+    post_events(0);
+    wait_for([&executor] { return executor.processed()[0] == 4 * events_per_key; });
+
+    // Half of the load of shard 0, two keys, is moved to shard 1.
+    EXPECT_TRUE(executor.rebalance());
+    wait_for([&executor] { return executor.migrations() == 2; });
+
+    // Events for migrated machines are forwarded in order.
+    post_events(events_per_key);
+    executor.stop();
+
+    EXPECT_EQ(2, executor.migrations());
+    EXPECT_EQ((std::vector<uint64_t>{6 * events_per_key, 2 * events_per_key}),
+              executor.processed());
+    for (auto k : keys) {
+        const auto& c = executor.find(k)->current_state().get<counting>();
+        EXPECT_EQ(2 * events_per_key, c.count);
+        EXPECT_TRUE(c.in_order);
+    }
+
+    // The load is balanced, so nothing is migrated.
+    executor.start(false);
+    post_events(2 * events_per_key);
+    executor.stop();
+    EXPECT_FALSE(executor.rebalance());
+}
@@ -0,0 +1,117 @@
+#include "state_machine/slab_pool.h"
+
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+using ::state_machine::pool::slab_pool;
+
+struct big {
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+    std::uint64_t data[32];
+};
+
+struct remote {
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+    std::uint64_t data[8];
+};
+
+} // namespace
+
+TEST(slab_pool, allocate_distinct_slots) {
+    using pool = slab_pool<big, 4>;
+
+    // Allocate across more than one slab.
+    auto slots = std::set<void*>{};
+    for (auto i = 0U; i < (3 * pool::slots_per_slab); ++i) {
+        slots.insert(pool::allocate());
+    }
+
+    EXPECT_EQ(slots.size(), 3 * pool::slots_per_slab);
+
+    for (auto* slot : slots) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(slot) % alignof(big), 0U);
+        pool::deallocate(slot);
+    }
+}
+
+TEST(slab_pool, deallocated_slot_is_reused) {
+    using pool = slab_pool<big>;
+
+    auto* first = pool::allocate();
+    pool::deallocate(first);
+
+    auto* second = pool::allocate();
+    EXPECT_EQ(first, second);
+
+    pool::deallocate(second);
+}
+
+TEST(slab_pool, slots_freed_by_exited_thread_are_reused) {
+    using pool = slab_pool<remote, 4>;
+    constexpr std::size_t batch = 16;
+
+    // Slots allocated on this thread and freed on threads that then exit return to this thread.
+    auto seen = std::set<void*>{};
+    for (auto round = 0; round < 100; ++round) {
+        auto slots = std::vector<void*>{};
+        for (std::size_t i = 0; i < batch; ++i) {
+            slots.push_back(pool::allocate());
+        }
+        seen.insert(slots.begin(), slots.end());
+
+        std::thread{[&slots] {
+            for (auto* slot : slots) {
+                pool::deallocate(slot);
+            }
+        }}.join();
+    }
+
+    EXPECT_GE(2 * batch, seen.size());
+}
+
+TEST(slab_pool, slots_freed_by_running_thread_are_reused) {
+    using pool = slab_pool<remote, 8>;
+    constexpr std::size_t batch = 64;
+    constexpr int rounds = 100;
+
+    // A thread that keeps running frees the slots allocated on this thread. Slots it caches beyond
+    // `max_cached` are shared, so this thread stops allocating slabs.
+    auto slots = std::vector<void*>{};
+    std::atomic<int> freed{0};
+    std::atomic<int> allocated{0};
+    std::thread freeing{[&] {
+        for (auto round = 1; round <= rounds; ++round) {
+            while (allocated.load() != round) {
+                std::this_thread::yield();
+            }
+            for (auto* slot : slots) {
+                pool::deallocate(slot);
+            }
+            freed.store(round);
+        }
+    }};
+
+    auto seen = std::set<void*>{};
+    for (auto round = 1; round <= rounds; ++round) {
+        slots.clear();
+        for (std::size_t i = 0; i < batch; ++i) {
+            slots.push_back(pool::allocate());
+        }
+        seen.insert(slots.begin(), slots.end());
+
+        allocated.store(round);
+        while (freed.load() != round) {
+            std::this_thread::yield();
+        }
+    }
+    freeing.join();
+
+    EXPECT_GE(batch + pool::max_cached, seen.size());
+}
@@ -4,10 +4,15 @@
 #include "state_machine/transition/transition_table.h"
 
 #include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace {
 using ::state_machine::event;
+using ::state_machine::reuse;
 using ::state_machine::state;
 using ::state_machine::placeholder::_;
 
@@ -26,6 +31,8 @@ struct s3 {
 struct e1 {};
 struct e2 {};
 struct e3 {
+    // Events processed by index must be default constructible.
+    e3() = default;
     constexpr explicit e3(int x) : value{x} {}
     int value;
 };
@@ -90,6 +97,433 @@ TEST(state_machine, state_types) {
     static_assert(std::is_same<SM::state_types, list<s1, s3, s2>>::value, "");
 }
 
+TEST(state_machine, visit_two_machines) {
+    StateMachine<decltype(generate_table())> sm1{generate_table()};
+    StateMachine<decltype(generate_table())> sm2{generate_table()};
+
+    sm2.process_event(e3{7});
+
+    const auto same_state = [](const auto& a, const auto& b) {
+        return std::is_same<decltype(a), decltype(b)>::value;
+    };
+
+    EXPECT_FALSE(::state_machine::visit(same_state, sm1.current_state(), sm2.current_state()));
+
+    sm1.process_event(e3{7});
+    EXPECT_TRUE(::state_machine::visit(same_state, sm1.current_state(), sm2.current_state()));
+}
+
+TEST(state_machine, trivially_copyable) {
+    // `std::tuple` is not trivially copyable so the table is held by reference.
+    static constexpr auto table = generate_table();
+    using SM = StateMachine<const decltype(table)&>;
+
+    static_assert(std::is_trivially_copyable<SM>::value, "");
+    static_assert(std::is_trivially_destructible<SM>::value, "");
+
+    struct s4 {
+        // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+        auto on_exit() -> void {}
+    };
+
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(state<s4>, event<e2>, _, return_s2{}, state<s2>);
+    };
+
+    static_assert(!std::is_trivially_destructible<StateMachine<decltype(generate_table())>>::value,
+                  "");
+
+    SM sm1{table};
+    sm1.process_event(e3{7});
+
+    SM sm2{table};
+    std::memcpy(static_cast<void*>(&sm2), &sm1, sizeof(SM));
+
+    EXPECT_TRUE(sm2.is_state<s3>());
+    EXPECT_EQ(process_status::Completed, sm2.process_event(e3{1}));
+    EXPECT_TRUE(sm2.is_state<s2>());
+}
+
+TEST(state_machine, packed_policy) {
+    struct idle {};
+    struct reading {
+        // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+        std::uint16_t counts[3];
+    };
+    struct timing {
+        std::uint32_t ticks;
+    };
+
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<idle>,
+            event<e1>,
+            _,
+            []() { return reading{{1, 2, 3}}; },
+            state<reading>,
+            state<reading>,
+            event<e2>,
+            _,
+            [](const reading& r) { return timing{r.counts[2]}; },
+            state<timing>);
+    };
+
+    using PackedSM = StateMachine<decltype(generate_table()), ::state_machine::packed_policy>;
+    using SM = StateMachine<decltype(generate_table())>;
+
+    static_assert(sizeof(PackedSM::variant_type) < sizeof(SM::variant_type), "");
+
+    PackedSM sm{generate_table()};
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    EXPECT_TRUE(sm.is_state<reading>());
+    EXPECT_EQ(process_status::Completed, sm.process_event(e2{}));
+    EXPECT_TRUE(sm.is_state<timing>());
+    EXPECT_EQ(sm.current_state().get<timing>().ticks, 3U);
+}
+
+TEST(state_machine, boxed_policy) {
+    struct idle {};
+    struct receiving {
+        // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+        char buffer[4096];
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<idle>, event<e1>, _, []() { return receiving{}; }, state<receiving>,
+            state<receiving>, event<e2>, _, []() { return idle{}; }, state<idle>);
+        // clang-format on
+    };
+
+    using SM = StateMachine<decltype(generate_table()), ::state_machine::boxed_policy<receiving>>;
+
+    static_assert(sizeof(SM::variant_type) <= 2 * sizeof(void*), "");
+
+    SM sm{generate_table()};
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    const auto* address = sm.current_state().get_if<receiving>();
+    EXPECT_NE(address, nullptr);
+
+    // The slot for `receiving` is reused when cycling through the boxed state.
+    EXPECT_EQ(process_status::Completed, sm.process_event(e2{}));
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    EXPECT_EQ(sm.current_state().get_if<receiving>(), address);
+}
+
+TEST(state_machine, pmr_policy) {
+    using ::state_machine::pmr::allocator;
+    using buffer = std::vector<int, ::state_machine::pmr::polymorphic_allocator<int>>;
+
+    struct idle {
+        using allocator_type = allocator;
+
+        idle(std::allocator_arg_t, const allocator_type& alloc) : resource{alloc.resource()} {}
+
+        ::state_machine::pmr::memory_resource* resource;
+    };
+
+    struct receiving {
+        buffer data;
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<idle>, event<e3>, _, [](const e3& e, const allocator& alloc) {
+                auto data = buffer{alloc};
+                data.push_back(e.value);
+                return receiving{std::move(data)};
+            }, state<receiving>,
+            state<receiving>, event<e1>, _, []() {
+                return ::state_machine::emplace<idle>();
+            }, state<idle>);
+        // clang-format on
+    };
+
+    using SM = StateMachine<decltype(generate_table()), ::state_machine::pmr_policy<>>;
+
+    ::state_machine::pmr::monotonic_buffer_resource resource;
+    auto sm = SM{std::allocator_arg, allocator{&resource}, generate_table()};
+
+    EXPECT_EQ(sm.get_allocator().resource(), &resource);
+    EXPECT_EQ(sm.current_state().get_if<idle>()->resource, &resource);
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(e3{1}));
+    const auto& data = sm.current_state().get_if<receiving>()->data;
+    EXPECT_EQ(data.get_allocator().resource(), &resource);
+    EXPECT_EQ(data.front(), 1);
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    EXPECT_EQ(sm.current_state().get_if<idle>()->resource, &resource);
+}
+
+TEST(state_machine, allocator_policy) {
+    struct tagged_allocator {
+        int tag = 0;
+    };
+
+    struct tagged_policy : ::state_machine::default_policy {
+        using allocator_type = tagged_allocator;
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<s1>, event<e3>, _, [](const e3& e, const tagged_allocator& a) {
+                return s3{e.value + a.tag};
+            }, state<s3>);
+        // clang-format on
+    };
+
+    using SM = StateMachine<decltype(generate_table()), tagged_policy>;
+
+    auto sm = SM{std::allocator_arg, tagged_allocator{10}, generate_table()};
+    EXPECT_EQ(process_status::Completed, sm.process_event(e3{1}));
+    EXPECT_EQ(sm.current_state().get_if<s3>()->value, 11);
+}
+
+namespace pmr_move {
+
+using ::state_machine::pmr::allocator;
+
+struct uses_resource {
+    using allocator_type = allocator;
+
+    uses_resource(std::allocator_arg_t, const allocator_type& alloc)
+        : resource{alloc.resource()} {}
+
+    ::state_machine::pmr::memory_resource* resource;
+};
+
+struct idle : uses_resource {
+    using uses_resource::uses_resource;
+};
+
+struct busy : uses_resource {
+    using uses_resource::uses_resource;
+};
+
+struct start {
+    constexpr start() = default;
+    auto operator()(const e1&, const allocator& alloc) const -> busy {
+        return busy{std::allocator_arg, alloc};
+    }
+};
+
+constexpr auto table =
+    make_table_from_transition_args(state<idle>, event<e1>, _, start{}, state<busy>);
+
+} // namespace pmr_move
+
+TEST(state_machine, pmr_policy_move_assign) {
+    using table_type = ::state_machine::static_table<decltype(pmr_move::table), pmr_move::table>;
+    using SM = StateMachine<table_type, ::state_machine::pmr_policy<>>;
+    using pmr_move::allocator;
+
+    ::state_machine::pmr::monotonic_buffer_resource resource1;
+    ::state_machine::pmr::monotonic_buffer_resource resource2;
+    auto sm1 = SM{std::allocator_arg, allocator{&resource1}};
+    auto sm2 = SM{std::allocator_arg, allocator{&resource2}};
+    EXPECT_EQ(process_status::Completed, sm1.process_event(e1{}));
+
+    // The allocator is moved with the states constructed with it.
+    sm2 = std::move(sm1);
+    EXPECT_EQ(sm2.get_allocator().resource(), &resource1);
+    EXPECT_EQ(sm2.current_state().get_if<pmr_move::busy>()->resource, &resource1);
+}
+
+TEST(state_machine, recycling_policy) {
+    struct idle {};
+    struct receiving {
+        explicit receiving(int n) : id{n} {}
+
+        auto reset(int n) -> void {
+            id = n;
+            buffer.clear();
+        }
+
+        int id;
+        std::vector<int> buffer;
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<idle>, event<e3>, _, [](const e3& e) {
+                return ::state_machine::emplace<receiving>(e.value);
+            }, state<receiving>,
+            state<receiving>, event<e3>, _, [](receiving& r, const e3& e) {
+                r.buffer.push_back(e.value);
+            }, _,
+            state<receiving>, event<e1>, _, []() { return idle{}; }, state<idle>);
+        // clang-format on
+    };
+
+    using SM =
+        StateMachine<decltype(generate_table()), ::state_machine::recycling_policy<receiving>>;
+
+    SM sm{generate_table()};
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(e3{1}));
+    for (auto i = 0; i < 100; ++i) {
+        EXPECT_EQ(process_status::Completed, sm.process_event(e3{i}));
+    }
+
+    const auto* buffer = sm.current_state().get_if<receiving>()->buffer.data();
+    const auto capacity = sm.current_state().get_if<receiving>()->buffer.capacity();
+
+    // Leaving and re-entering `receiving` reuses the parked state and its buffer.
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    EXPECT_EQ(process_status::Completed, sm.process_event(e3{2}));
+
+    const auto& r = *sm.current_state().get_if<receiving>();
+    EXPECT_EQ(r.id, 2);
+    EXPECT_TRUE(r.buffer.empty());
+    EXPECT_EQ(r.buffer.capacity(), capacity);
+    EXPECT_EQ(r.buffer.data(), buffer);
+}
+
+TEST(state_machine, never_empty) {
+    struct nothrow {
+        explicit nothrow(int x) noexcept : value{x} {}
+        int value;
+    };
+    struct throwing {
+        explicit throwing(int) {}
+    };
+
+    const auto generate_nothrow_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<s1>, event<e1>, _, []() { return s2{}; }, state<s2>,
+            state<s2>, event<e3>, _, [](const e3& e) {
+                return ::state_machine::emplace<nothrow>(e.value);
+            }, state<nothrow>);
+        // clang-format on
+    };
+
+    const auto generate_throwing_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<s1>, event<e3>, _, [](const e3& e) {
+                return ::state_machine::emplace<throwing>(e.value);
+            }, state<throwing>);
+        // clang-format on
+    };
+
+    static_assert(StateMachine<decltype(generate_nothrow_table())>::never_empty, "");
+    static_assert(!StateMachine<decltype(generate_throwing_table())>::never_empty, "");
+    static_assert(StateMachine<decltype(generate_throwing_table()),
+                               ::state_machine::double_buffer_policy>::never_empty,
+                  "");
+}
+
+TEST(state_machine, double_buffer_policy) {
+    struct failure {};
+    struct unreliable {
+        explicit unreliable(int x) {
+            if (x < 0) {
+                throw failure{};
+            }
+        }
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<s1>, event<e3>, _, [](const e3& e) {
+                return ::state_machine::emplace<unreliable>(e.value);
+            }, state<unreliable>,
+            state<unreliable>, event<e1>, _, []() { return s1{}; }, state<s1>);
+        // clang-format on
+    };
+
+    StateMachine<decltype(generate_table()), ::state_machine::double_buffer_policy> sm{
+        generate_table()};
+
+    // A destination that fails to construct leaves the machine in the source state.
+    EXPECT_THROW(sm.process_event(e3{-1}), failure);
+    EXPECT_TRUE(sm.is_state<s1>());
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(e3{1}));
+    EXPECT_TRUE(sm.is_state<unreliable>());
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    EXPECT_TRUE(sm.is_state<s1>());
+}
+
+TEST(state_machine, process_event_noexcept) {
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<s1>, event<e1>, _, []() noexcept { return s2{}; }, state<s2>,
+            state<s2>, event<e2>, _, []() { return s1{}; }, state<s1>);
+        // clang-format on
+    };
+
+    using SM = StateMachine<decltype(generate_table())>;
+
+    SM sm{generate_table()};
+
+    static_assert(noexcept(sm.process_event(e1{})), "");
+    static_assert(!noexcept(sm.process_event(e2{})), "");
+}
+
+TEST(state_machine, status_policy) {
+    struct idle {};
+    struct receiving {
+        // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+        char buffer[256];
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<idle>, event<e1>, _, []() noexcept { return idle{}; }, state<idle>,
+            state<idle>, event<e2>, _, []() { return receiving{}; }, state<receiving>);
+        // clang-format on
+    };
+
+    using policy = ::state_machine::status_policy<::state_machine::boxed_policy<receiving>>;
+    using SM = StateMachine<decltype(generate_table()), policy>;
+
+    static_assert(!SM::never_empty, "");
+    static_assert(SM::is_nothrow_event<e1&&>::value, "");
+    using throwing_sm =
+        StateMachine<decltype(generate_table()), ::state_machine::boxed_policy<receiving>>;
+    static_assert(!throwing_sm::is_nothrow_event<e1&&>::value, "");
+
+    SM sm{generate_table()};
+    EXPECT_EQ(process_status::Completed, sm.process_event(e2{}));
+
+    // Moving a boxed state leaves the moved-from machine without a state.
+    SM other{std::move(sm)};
+    EXPECT_TRUE(other.is_state<receiving>());
+    // NOLINTNEXTLINE(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+    EXPECT_EQ(process_status::InvalidState, sm.process_event(e1{}));
+}
+
+TEST(state_machine, bad_state_access) {
+    struct idle {};
+    struct receiving {};
+
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<idle>, event<e1>, _, []() { return receiving{}; }, state<receiving>);
+    };
+
+    using SM = StateMachine<decltype(generate_table()), ::state_machine::boxed_policy<idle>>;
+
+    SM sm{generate_table()};
+    SM other{std::move(sm)};
+
+    // NOLINTNEXTLINE(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+    EXPECT_THROW(sm.process_event(e1{}), ::state_machine::state_machine::bad_state_access);
+    EXPECT_EQ(process_status::Completed, other.process_event(e1{}));
+}
+
 TEST(state_machine, emplace_initial_state) {
     struct s4 {
         constexpr explicit s4(int i) : value{i} {}
@@ -149,6 +583,67 @@ TEST(state_machine, on_exit_state_sm_dtor) {
     EXPECT_EQ(on_exit_count, 1);
 }
 
+TEST(state_machine, on_exit_state_sm_move) {
+    static int on_exit_count;
+
+    struct s4 {
+        constexpr s4() = default;
+
+        // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+        auto on_exit() -> void { on_exit_count++; }
+    };
+
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(state<s4>, event<e2>, _, return_s2{}, state<s2>);
+    };
+    using SM = StateMachine<decltype(generate_table())>;
+
+    {
+        SM sm{generate_table()};
+        SM other{std::move(sm)};
+
+        // The moved-from machine holds no state, so `on_exit` is only called by `other`.
+        // NOLINTNEXTLINE(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+        EXPECT_FALSE(sm.is_state<s4>());
+        EXPECT_TRUE(other.is_state<s4>());
+    }
+    EXPECT_EQ(on_exit_count, 1);
+}
+
+namespace on_exit_move_assign {
+
+int on_exit_count = 0;
+
+struct s4 {
+    constexpr s4() = default;
+
+    // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+    auto on_exit() -> void { on_exit_count++; }
+};
+
+constexpr auto table =
+    make_table_from_transition_args(state<s4>, event<e2>, _, return_s2{}, state<s2>);
+
+} // namespace on_exit_move_assign
+
+TEST(state_machine, on_exit_state_sm_move_assign) {
+    using on_exit_move_assign::on_exit_count;
+    using table_type = ::state_machine::static_table<decltype(on_exit_move_assign::table),
+                                                     on_exit_move_assign::table>;
+    using SM = StateMachine<table_type>;
+
+    {
+        SM sm{};
+        SM other{};
+
+        // The state replaced in `other` exits, the state moved from `sm` exits once with `other`.
+        other = std::move(sm);
+        EXPECT_EQ(on_exit_count, 1);
+        EXPECT_TRUE(other.is_state<on_exit_move_assign::s4>());
+    }
+    EXPECT_EQ(on_exit_count, 2);
+}
+
 TEST(state_machine, process_event) {
     {
         StateMachine<decltype(generate_table())> sm{generate_table()};
@@ -223,3 +718,435 @@ TEST(state_machine, process_event_table_reference) {
         EXPECT_TRUE(sm.is_state<s3>());
     }
 }
+
+namespace static_instance {
+constexpr auto table = generate_table();
+} // namespace static_instance
+
+TEST(state_machine, process_event_static_table) {
+    using table_type = ::state_machine::static_table<decltype(static_instance::table),
+                                                     static_instance::table>;
+    using sm_type = StateMachine<table_type>;
+
+    static_assert(sizeof(sm_type) == sizeof(sm_type::variant_type), "");
+    static_assert(std::is_same<sm_type::table_type, decltype(generate_table())>::value, "");
+
+    std::vector<sm_type> machines(2);
+    ASSERT_TRUE(machines[0].is_state<s1>());
+    ASSERT_TRUE(machines[1].is_state<s1>());
+
+    EXPECT_EQ(process_status::Completed, machines[0].process_event(e2{}));
+    EXPECT_TRUE(machines[0].is_state<s2>());
+    EXPECT_TRUE(machines[1].is_state<s1>());
+
+    EXPECT_EQ(process_status::Completed, machines[1].process_event(e3{0}));
+    EXPECT_TRUE(machines[1].is_state<s3>());
+    EXPECT_EQ(process_status::Completed, machines[1].process_event(e3{0}));
+    EXPECT_TRUE(machines[1].is_state<s3>());
+
+    machines[0] = std::move(machines[1]);
+    EXPECT_TRUE(machines[0].is_state<s3>());
+
+    sm_type sm{table_type{}};
+    EXPECT_TRUE(sm.is_state<s1>());
+}
+
+TEST(state_machine, process_event_all_state_indices) {
+    struct r0 {};
+    struct r1 {};
+    struct r2 {};
+    struct r3 {};
+    struct next {};
+
+    // clang-format off
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<r0>, event<next>, _, [] { return r1{}; }, state<r1>,
+            state<r1>, event<next>, _, [] { return r2{}; }, state<r2>,
+            state<r2>, event<next>, _, [] { return r3{}; }, state<r3>,
+            state<r3>, event<next>, _, [] { return r0{}; }, state<r0>,
+            state<r3>, event<e1>,   _,                  _,         _);
+    };
+    // clang-format on
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+    ASSERT_TRUE(sm.is_state<r0>());
+
+    EXPECT_EQ(process_status::UndefinedTransition, sm.process_event(e1{}));
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(next{}));
+    EXPECT_TRUE(sm.is_state<r1>());
+    EXPECT_EQ(process_status::Completed, sm.process_event(next{}));
+    EXPECT_TRUE(sm.is_state<r2>());
+    EXPECT_EQ(process_status::Completed, sm.process_event(next{}));
+    EXPECT_TRUE(sm.is_state<r3>());
+
+    EXPECT_EQ(process_status::EventIgnored, sm.process_event(e1{}));
+    EXPECT_TRUE(sm.is_state<r3>());
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(next{}));
+    EXPECT_TRUE(sm.is_state<r0>());
+}
+
+TEST(state_machine, process_event_id) {
+    using SM = StateMachine<decltype(generate_table())>;
+
+    static_assert(SM::event_index<e2>() == 0, "");
+    static_assert(SM::event_index<e1>() == 1, "");
+    static_assert(SM::event_index<e3>() == 2, "");
+
+    SM sm{generate_table()};
+    ASSERT_TRUE(sm.is_state<s1>());
+
+    const auto ignored = e1{};
+    EXPECT_EQ(process_status::EventIgnored, sm.process_event_id(SM::event_index<e1>(), &ignored));
+    EXPECT_TRUE(sm.is_state<s1>());
+
+    const auto to_s3 = e3{0};
+    EXPECT_EQ(process_status::Completed, sm.process_event_id(SM::event_index<e3>(), &to_s3));
+    EXPECT_TRUE(sm.is_state<s3>());
+
+    const auto to_s2 = e3{1};
+    EXPECT_EQ(process_status::Completed, sm.process_event_id(SM::event_index<e3>(), &to_s2));
+    EXPECT_TRUE(sm.is_state<s2>());
+
+    EXPECT_EQ(process_status::UndefinedTransition, sm.process_event_id(3, &to_s2));
+    EXPECT_TRUE(sm.is_state<s2>());
+}
+
+TEST(state_machine, process_event_id_unaligned) {
+    using SM = StateMachine<decltype(generate_table())>;
+
+    SM sm{generate_table()};
+
+    // The payload of a message following a one byte tag.
+    const auto event = e3{0};
+    alignas(e3) unsigned char message[1 + sizeof(e3)] = {};
+    message[0] = static_cast<unsigned char>(SM::event_index<e3>());
+    std::memcpy(&message[1], &event, sizeof(event));
+
+    EXPECT_EQ(process_status::Completed, sm.process_event_id(message[0], &message[1]));
+    EXPECT_TRUE(sm.is_state<s3>());
+    EXPECT_EQ(0, sm.current_state().get<s3>().value);
+}
+
+namespace copy_count {
+
+// Counts copies and moves of each type derived from `counted<Tag>`.
+template <class Tag>
+struct counted {
+    static int copies;
+    static int moves;
+
+    counted() = default;
+    counted(const counted&) { copies++; }
+    counted(counted&&) noexcept { moves++; }
+    auto operator=(const counted&) -> counted& = default;
+    auto operator=(counted&&) noexcept -> counted& = default;
+    ~counted() = default;
+
+    static auto reset() -> void {
+        copies = 0;
+        moves = 0;
+    }
+};
+
+template <class Tag>
+int counted<Tag>::copies;
+
+template <class Tag>
+int counted<Tag>::moves;
+
+struct source : counted<source> {};
+struct destination : counted<destination> {};
+struct event : counted<event> {};
+
+} // namespace copy_count
+
+class StateMachineCopyTest : public ::testing::Test {
+  protected:
+    using source = copy_count::source;
+    using destination = copy_count::destination;
+    using event = copy_count::event;
+
+    void SetUp() override {
+        source::reset();
+        destination::reset();
+        event::reset();
+    }
+};
+
+TEST_F(StateMachineCopyTest, process_event) {
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<source>, ::state_machine::event<event>,
+                [](const source&, const event&) { return false; },
+                [](source&, event&) { return destination{}; }, state<destination>,
+            state<source>, ::state_machine::event<event>,
+                [](const source&, const event&) { return true; },
+                [](source&, event&) { return destination{}; }, state<destination>);
+        // clang-format on
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+    ASSERT_TRUE(sm.is_state<source>());
+    ASSERT_EQ(source::copies, 0);
+    ASSERT_EQ(source::moves, 0);
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(event{}));
+    EXPECT_TRUE(sm.is_state<destination>());
+
+    EXPECT_EQ(source::copies, 0);
+    EXPECT_EQ(source::moves, 0);
+    EXPECT_EQ(event::copies, 0);
+    EXPECT_EQ(event::moves, 0);
+    EXPECT_EQ(destination::copies, 0);
+    EXPECT_LE(destination::moves, 1);
+}
+
+TEST_F(StateMachineCopyTest, process_event_emplace_destination) {
+    static int source_count;
+
+    struct buffer_source {
+        buffer_source() { source_count++; }
+        buffer_source(const buffer_source&) = delete;
+        buffer_source(buffer_source&&) noexcept { source_count++; }
+        auto operator=(const buffer_source&) -> buffer_source& = delete;
+        auto operator=(buffer_source&&) -> buffer_source& = delete;
+        ~buffer_source() { source_count--; }
+
+        int value = 42;
+    };
+
+    struct buffer_destination : destination {
+        explicit buffer_destination(int x) : value{x} {
+            // The source state is destroyed before the destination is constructed in its place.
+            EXPECT_EQ(source_count, 0);
+        }
+
+        int value;
+    };
+
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<buffer_source>, ::state_machine::event<event>, _,
+                [](buffer_source& s) {
+                    return ::state_machine::emplace<buffer_destination>(s.value);
+                }, state<buffer_destination>);
+        // clang-format on
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+    ASSERT_TRUE(sm.is_state<buffer_source>());
+    ASSERT_EQ(source_count, 1);
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(event{}));
+    EXPECT_TRUE(sm.is_state<buffer_destination>());
+    EXPECT_EQ(source_count, 0);
+
+    EXPECT_EQ(destination::copies, 0);
+    EXPECT_EQ(destination::moves, 0);
+}
+
+class StateMachineSelfTransitionTest : public ::testing::Test {
+  protected:
+    static int ctor_count;
+    static int move_ctor_count;
+    static int move_assign_count;
+    static int dtor_count;
+    static int on_entry_count;
+    static int on_exit_count;
+
+    struct heartbeat {};
+
+    struct alive {
+        alive() { ctor_count++; }
+        alive(const alive&) = delete;
+        alive(alive&&) noexcept { move_ctor_count++; }
+        auto operator=(const alive&) -> alive& = delete;
+        auto operator=(alive&&) noexcept -> alive& {
+            move_assign_count++;
+            return *this;
+        }
+        ~alive() { dtor_count++; }
+
+        // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+        auto on_entry() -> void { on_entry_count++; }
+        // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+        auto on_exit() -> void { on_exit_count++; }
+
+        int beats = 0;
+    };
+
+    void SetUp() override {
+        ctor_count = 0;
+        move_ctor_count = 0;
+        move_assign_count = 0;
+        dtor_count = 0;
+        on_entry_count = 0;
+        on_exit_count = 0;
+    }
+};
+
+int StateMachineSelfTransitionTest::ctor_count;
+int StateMachineSelfTransitionTest::move_ctor_count;
+int StateMachineSelfTransitionTest::move_assign_count;
+int StateMachineSelfTransitionTest::dtor_count;
+int StateMachineSelfTransitionTest::on_entry_count;
+int StateMachineSelfTransitionTest::on_exit_count;
+
+TEST_F(StateMachineSelfTransitionTest, destroy_construct) {
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<alive>, event<heartbeat>, _, [] { return alive{}; }, state<alive>);
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+    ASSERT_EQ(ctor_count, 1);
+
+    // Without `reuse`, the source state is destroyed and the destination constructed.
+    EXPECT_EQ(process_status::Completed, sm.process_event(heartbeat{}));
+    EXPECT_TRUE(sm.is_state<alive>());
+
+    EXPECT_EQ(on_exit_count, 1);
+    EXPECT_EQ(on_entry_count, 2);
+    EXPECT_EQ(move_assign_count, 0);
+    EXPECT_EQ(move_ctor_count, 1);
+    // The source state and the temporary returned by the action are destroyed.
+    EXPECT_EQ(dtor_count, 2);
+}
+
+TEST_F(StateMachineSelfTransitionTest, move_assign) {
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<alive>, event<heartbeat>, _, [] { return alive{}; }, state<reuse<alive>>);
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+    ASSERT_EQ(ctor_count, 1);
+    ASSERT_EQ(on_entry_count, 1);
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(heartbeat{}));
+    EXPECT_TRUE(sm.is_state<alive>());
+
+    EXPECT_EQ(on_exit_count, 1);
+    EXPECT_EQ(on_entry_count, 2);
+    EXPECT_EQ(ctor_count, 2);
+    EXPECT_EQ(move_ctor_count, 0);
+    EXPECT_EQ(move_assign_count, 1);
+    // Only the temporary returned by the action is destroyed.
+    EXPECT_EQ(dtor_count, 1);
+}
+
+TEST_F(StateMachineSelfTransitionTest, mutate_source) {
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<alive>,
+            event<heartbeat>,
+            _,
+            [](alive& s) -> alive& {
+                s.beats++;
+                return s;
+            },
+            state<reuse<alive>>,
+            state<alive>,
+            event<e1>,
+            [](const alive& s) { return s.beats == 2; },
+            [] { return s1{}; },
+            state<s1>);
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+    ASSERT_EQ(ctor_count, 1);
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(heartbeat{}));
+    EXPECT_EQ(process_status::Completed, sm.process_event(heartbeat{}));
+    EXPECT_TRUE(sm.is_state<alive>());
+
+    EXPECT_EQ(on_exit_count, 2);
+    EXPECT_EQ(on_entry_count, 3);
+    EXPECT_EQ(ctor_count, 1);
+    EXPECT_EQ(move_ctor_count, 0);
+    EXPECT_EQ(move_assign_count, 0);
+    EXPECT_EQ(dtor_count, 0);
+
+    // The state object was kept across both self-transitions.
+    EXPECT_EQ(process_status::Completed, sm.process_event(e1{}));
+    EXPECT_TRUE(sm.is_state<s1>());
+}
+
+TEST_F(StateMachineCopyTest, process_event_value_categories) {
+    const auto generate_table = []() noexcept {
+        // clang-format off
+        return make_table_from_transition_args(
+            state<source>, ::state_machine::event<event>, _,
+                [](const event&) { return destination{}; }, state<destination>,
+            state<destination>, ::state_machine::event<event>, _,
+                [](const event&) { return source{}; }, state<source>);
+        // clang-format on
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+
+    auto e = event{};
+    EXPECT_EQ(process_status::Completed, sm.process_event(e));
+    EXPECT_TRUE(sm.is_state<destination>());
+
+    const auto& const_e = e;
+    EXPECT_EQ(process_status::Completed, sm.process_event(const_e));
+    EXPECT_TRUE(sm.is_state<source>());
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(std::move(e)));
+    EXPECT_TRUE(sm.is_state<destination>());
+
+    EXPECT_EQ(event::copies, 0);
+    EXPECT_EQ(event::moves, 0);
+}
+
+TEST_F(StateMachineCopyTest, process_event_mutable_event_action) {
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<source>,
+            ::state_machine::event<event>,
+            _,
+            [](event&) { return destination{}; },
+            state<destination>);
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+
+    // A const event is rejected at compile time instead of being copied, see
+    // failure_action_mutable_const_event.cc.
+    EXPECT_EQ(process_status::Completed, sm.process_event(event{}));
+    EXPECT_EQ(event::copies, 0);
+}
+
+TEST(state_machine, process_event_move_from_event) {
+    struct receiving {};
+    struct processing {
+        std::vector<int> buffer;
+    };
+    struct received {
+        std::vector<int> buffer;
+    };
+
+    const auto generate_table = []() noexcept {
+        return make_table_from_transition_args(
+            state<receiving>,
+            event<received>,
+            _,
+            [](received&& e) { return processing{std::move(e.buffer)}; },
+            state<processing>);
+    };
+
+    StateMachine<decltype(generate_table())> sm{generate_table()};
+
+    auto e = received{{1, 2, 3}};
+
+    EXPECT_EQ(process_status::Completed, sm.process_event(std::move(e)));
+    EXPECT_TRUE(sm.is_state<processing>());
+    // NOLINTNEXTLINE(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+    EXPECT_TRUE(e.buffer.empty());
+}
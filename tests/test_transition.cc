@@ -212,3 +212,29 @@ TEST(transition, invoke_action_se) {
     static_assert(std::is_same<decltype(transition.action(s, e)), s2>::value, "");
     static_assert(std::is_same<decltype(transition.invoke_action(s, e)), s2>::value, "");
 }
+
+TEST(transition, invoke_action_emplace) {
+    using ::state_machine::transition::in_place_construct;
+
+    struct s3 {
+        explicit s3(int x) : value{x} {}
+        int value;
+    };
+
+    auto transition = make_transition(
+        state<s1>,
+        event<e2>,
+        _,
+        [](e2& e) { return ::state_machine::emplace<s3>(e.value); },
+        state<s3>);
+
+    auto s = s1{};
+    auto e = e2{1};
+
+    static_assert(
+        std::is_same<decltype(transition.invoke_action(s, e)), in_place_construct<s3, int>>::value,
+        "");
+
+    const s3 d = transition.invoke_action(s, e);
+    EXPECT_EQ(d.value, 1);
+}
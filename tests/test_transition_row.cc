@@ -113,3 +113,51 @@ TEST(transition_row, find_guard_failure) {
     const auto index = row.find_transition(s1{}, e1{0});
     ASSERT_FALSE(index);
 }
+
+namespace {
+
+// Counts copies of each type derived from `counted<Tag>`.
+template <class Tag>
+struct counted {
+    static int copies;
+
+    counted() = default;
+    counted(const counted&) { copies++; }
+    counted(counted&&) noexcept { copies++; }
+    auto operator=(const counted&) -> counted& = default;
+    auto operator=(counted&&) noexcept -> counted& = default;
+    ~counted() = default;
+};
+
+template <class Tag>
+int counted<Tag>::copies;
+
+struct counted_source : counted<counted_source> {};
+struct counted_event : counted<counted_event> {};
+
+} // namespace
+
+TEST(transition_row, find_transition_no_copies) {
+    const auto transition = [](bool result) {
+        return make_transition(
+            state<counted_source>,
+            event<counted_event>,
+            [result](const counted_source&, const counted_event&) { return result; },
+            [] { return s2{}; },
+            state<s2>);
+    };
+
+    const auto row = make_row(transition(false), transition(false), transition(true));
+
+    const auto source = counted_source{};
+    const auto e = counted_event{};
+    counted<counted_source>::copies = 0;
+    counted<counted_event>::copies = 0;
+
+    const auto index = row.find_transition(source, e);
+    ASSERT_TRUE(index);
+    EXPECT_EQ(*index, 2);
+
+    EXPECT_EQ(counted<counted_source>::copies, 0);
+    EXPECT_EQ(counted<counted_event>::copies, 0);
+}
@@ -3,12 +3,14 @@
 
 #include "gtest/gtest.h"
 #include <tuple>
+#include <type_traits>
 
 namespace {
 using ::state_machine::event;
 using ::state_machine::state;
 using ::state_machine::placeholder::_;
 
+using ::state_machine::containers::list;
 using ::state_machine::transition::make_row;
 using ::state_machine::transition::make_table;
 using ::state_machine::transition::make_table_from_transition_args;
@@ -28,6 +30,14 @@ struct e3 {
     int value;
 };
 
+struct return_s1 {
+    constexpr auto operator()() const noexcept -> s1 { return {}; }
+};
+
+struct return_s2 {
+    constexpr auto operator()() const noexcept -> s2 { return {}; }
+};
+
 } // namespace
 
 TEST(transition_table, make_table) {
@@ -108,12 +118,18 @@ TEST(transition_table, multiple_updates) {
 TEST(transition_table, make_table_from_transition_args) {
     // clang-format off
     auto table = make_table_from_transition_args(
-        state<s1>, event<e2>,                                   _,                         [] { return s2{}; }, state<s2>,
-        state<s1>, event<e1>,                                   _,                                       [] {},         _,
-        state<s1>, event<e2>,                                   _,                        [] { return s3{3}; }, state<s3>,
-        state<s1>, event<e3>,                                   _, [](auto e) noexcept { return s3{e.value}; }, state<s3>,
-        state<s3>, event<e3>,  [](auto e) { return e.value > 0; },                         [] { return s2{}; }, state<s2>,
-        state<s3>, event<e3>, [](auto e) { return e.value == 0; },                        [] { return s3{0}; }, state<s3>);
+        state<s1>, event<e2>, _,
+            [] { return s2{}; }, state<s2>,
+        state<s1>, event<e1>, _,
+            [] {}, _,
+        state<s1>, event<e2>, _,
+            [] { return s3{3}; }, state<s3>,
+        state<s1>, event<e3>, _,
+            [](auto e) noexcept { return s3{e.value}; }, state<s3>,
+        state<s3>, event<e3>, [](auto e) { return e.value > 0; },
+            [] { return s2{}; }, state<s2>,
+        state<s3>, event<e3>, [](auto e) { return e.value == 0; },
+            [] { return s3{0}; }, state<s3>);
     static_assert(decltype(table)::size == 4, "");
     // clang-format on
 
@@ -121,3 +137,32 @@ TEST(transition_table, make_table_from_transition_args) {
     using FirstKey = std::decay_t<decltype(std::get<0>(table.data()))>::key_type;
     static_assert(std::is_same<FirstKey, tr::Key<tr::State<s1>, tr::Event<e2>>>::value, "");
 }
+
+TEST(transition_table, transition_matrix) {
+    // clang-format off
+    constexpr auto table = make_table_from_transition_args(
+        state<s1>, event<e2>, _, return_s2{}, state<s2>,
+        state<s1>, event<e1>, _,           _,         _,
+        state<s2>, event<e1>, _, return_s1{}, state<s1>);
+    // clang-format on
+
+    using Table = std::decay_t<decltype(table)>;
+
+    static_assert(std::is_same<Table::state_types, list<s1, s2>>::value, "");
+    static_assert(std::is_same<Table::event_types, list<e2, e1>>::value, "");
+    static_assert(Table::num_states == 2, "");
+    static_assert(Table::num_events == 2, "");
+
+    static_assert(Table::event_index_map::at_key<e2>::value == 0, "");
+    static_assert(Table::event_index_map::at_key<e1>::value == 1, "");
+    static_assert(Table::state_index_map::at_key<s1>::value == 0, "");
+    static_assert(Table::state_index_map::at_key<s2>::value == 1, "");
+
+    static_assert(Table::row_index(0, 0) == 0, "");
+    static_assert(Table::row_index(0, 1) == 1, "");
+    static_assert(Table::row_index(1, 0) == Table::undefined_row, "");
+    static_assert(Table::row_index(1, 1) == 2, "");
+
+    EXPECT_EQ(Table::transition_matrix.size(), 4);
+    EXPECT_EQ(Table::transition_matrix[2], Table::undefined_row);
+}
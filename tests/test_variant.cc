@@ -1,6 +1,9 @@
 #include "state_machine/variant.h"
 
 #include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace {
 using ::state_machine::variant::bad_variant_access;
@@ -224,6 +227,72 @@ TEST(variant, visit_type_index) {
     EXPECT_EQ(v.visit([](auto a) { return a.value; }), D::value);
 }
 
+TEST(variant, visit_const) {
+    using visit::C;
+    using visit::D;
+
+    Variant<C, D> v{};
+    v.emplace<D>();
+
+    const auto& cv = v;
+    EXPECT_EQ(cv.visit([](auto& a) {
+        static_assert(std::is_const<std::remove_reference_t<decltype(a)>>::value, "");
+        return a.value;
+    }),
+              D::value);
+}
+
+namespace visit {
+template <int N>
+struct E {
+    static constexpr int value = N;
+};
+template <int N>
+constexpr int E<N>::value;
+} // namespace visit
+
+TEST(variant, visit_many_alternatives) {
+    using visit::E;
+
+    Variant<E<0>, E<1>, E<2>, E<3>, E<4>, E<5>, E<6>, E<7>, E<8>, E<9>> v{};
+
+    v.emplace<E<0>>();
+    EXPECT_EQ(v.visit([](auto a) { return a.value; }), 0);
+
+    v.emplace<E<5>>();
+    EXPECT_EQ(v.visit([](auto a) { return a.value; }), 5);
+
+    v.emplace<E<9>>();
+    EXPECT_EQ(v.visit([](auto a) { return a.value; }), 9);
+}
+
+TEST(variant, visit_two_variants) {
+    using ::state_machine::variant::visit;
+    using visit::C;
+    using visit::D;
+    using visit::E;
+
+    Variant<C, D> v1{};
+    Variant<E<3>, E<4>, E<5>> v2{};
+
+    const auto combine = [](auto a, auto b) { return (10 * a.value) + b.value; };
+
+    EXPECT_THROW(visit(combine, v1, v2), bad_variant_access);
+
+    v1.emplace<C>();
+    EXPECT_THROW(visit(combine, v1, v2), bad_variant_access);
+
+    v2.emplace<E<5>>();
+    EXPECT_EQ(visit(combine, v1, v2), 15);
+
+    v1.emplace<D>();
+    v2.emplace<E<3>>();
+    EXPECT_EQ(visit(combine, v1, v2), 23);
+
+    const auto& cv2 = v2;
+    EXPECT_EQ(visit(combine, v1, cv2), 23);
+}
+
 class VariantMoveTest : public ::testing::Test {
   protected:
     static int ctor_count;
@@ -314,12 +383,12 @@ TEST_F(VariantMoveTest, move_assign_emplace_C) {
         v2 = std::move(v1);
 
         EXPECT_EQ(ctor_count, 1);
-        EXPECT_EQ(move_ctor_count, 2);
-        EXPECT_EQ(dtor_count, 1);
+        EXPECT_EQ(move_ctor_count, 1);
+        EXPECT_EQ(dtor_count, 0);
     }
     EXPECT_EQ(ctor_count, 1);
-    EXPECT_EQ(move_ctor_count, 2);
-    EXPECT_EQ(dtor_count, 3);
+    EXPECT_EQ(move_ctor_count, 1);
+    EXPECT_EQ(dtor_count, 2);
 }
 
 TEST_F(VariantMoveTest, move_assign_set_C) {
@@ -340,14 +409,14 @@ TEST_F(VariantMoveTest, move_assign_set_C) {
 
         v2 = std::move(v1);
 
-        // There's an extra temporary `C` when performing a move assignment
+        // The `C` held by `v2` is destroyed and the `C` held by `v1` is moved directly into `v2`.
         EXPECT_EQ(ctor_count, 2);
-        EXPECT_EQ(move_ctor_count, 3);
-        EXPECT_EQ(dtor_count, 3);
+        EXPECT_EQ(move_ctor_count, 2);
+        EXPECT_EQ(dtor_count, 2);
     }
     EXPECT_EQ(ctor_count, 2);
-    EXPECT_EQ(move_ctor_count, 3);
-    EXPECT_EQ(dtor_count, 5);
+    EXPECT_EQ(move_ctor_count, 2);
+    EXPECT_EQ(dtor_count, 4);
 }
 
 TEST_F(VariantMoveTest, move_assign_to_empty) {
@@ -372,3 +441,225 @@ TEST_F(VariantMoveTest, move_assign_to_empty) {
     EXPECT_EQ(move_ctor_count, 1);
     EXPECT_EQ(dtor_count, 2);
 }
+
+TEST(variant, trivially_copyable) {
+    struct T1 {
+        int value;
+    };
+    struct T2 {
+        double value;
+    };
+
+    using V = Variant<T1, T2>;
+
+    static_assert(std::is_trivially_copyable<V>::value, "");
+    static_assert(std::is_trivially_destructible<V>::value, "");
+    static_assert(std::is_trivially_move_constructible<V>::value, "");
+
+    struct T3 {
+        ~T3() {} // NOLINT(modernize-use-equals-default)
+    };
+
+    static_assert(!std::is_trivially_copyable<Variant<T1, T3>>::value, "");
+    static_assert(!std::is_trivially_destructible<Variant<T1, T3>>::value, "");
+
+    V v1{};
+    v1.emplace<T2>(1.5);
+
+    V v2{};
+    std::memcpy(&v2, &v1, sizeof(V));
+
+    EXPECT_TRUE(v2.holds<T2>());
+    EXPECT_EQ(v2.get<T2>().value, 1.5);
+}
+
+TEST(variant, move_ctor_potentially_throwing) {
+    struct T {
+        explicit T(int x) : value{x} {}
+        // NOLINTNEXTLINE(performance-noexcept-move-constructor)
+        T(T&& other) : value{other.value} { other.value = 0; }
+        T(const T&) = delete;
+        ~T() = default;
+        int value;
+    };
+
+    static_assert(!std::is_nothrow_move_constructible<Variant<T>>::value, "");
+
+    Variant<T> v1{};
+    v1.emplace<T>(3);
+
+    auto v2 = std::move(v1);
+
+    EXPECT_TRUE(v2.holds<T>());
+    EXPECT_EQ(v2.get<T>().value, 3);
+}
+
+TEST(variant, move_ctor_copy_constructible_only) {
+    static constexpr int expected = 5;
+    Variant<A, B> v1{};
+    v1.emplace<B>(expected);
+
+    auto v2 = std::move(v1);
+
+    EXPECT_TRUE(v2.holds<B>());
+    EXPECT_EQ(v2.get<B>().value, expected);
+}
+
+TEST(variant, move_assign_self) {
+    static constexpr int expected = 7;
+    Variant<A, B> v{};
+    v.emplace<A>(expected);
+
+    auto& ref = v;
+    v = std::move(ref);
+
+    EXPECT_TRUE(v.holds<A>());
+    EXPECT_EQ(v.get<A>().value, expected);
+}
+
+namespace packed {
+struct P6 {
+    // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+    std::uint16_t values[3];
+};
+struct P4 {
+    std::uint32_t value;
+};
+struct P8 {
+    std::uint64_t value;
+};
+} // namespace packed
+
+TEST(variant, index_packing) {
+    using ::state_machine::variant::index_packing;
+    using ::state_machine::variant::PackedVariant;
+    using packed::P4;
+    using packed::P6;
+    using packed::P8;
+
+    // The largest alternative is 6 bytes with 4 byte alignment, leaving a spare tail byte.
+    static_assert(index_packing<P4, P6>::value, "");
+    static_assert(index_packing<P4, P6>::size == 8, "");
+    static_assert(sizeof(PackedVariant<P4, P6>) == 8, "");
+    static_assert(sizeof(Variant<P4, P6>) == 12, "");
+
+    // No alternative leaves a spare byte, so the index is stored separately.
+    static_assert(!index_packing<P4, P8>::value, "");
+    static_assert(index_packing<P4, P8>::size == sizeof(Variant<P4, P8>), "");
+
+    static_assert(std::is_trivially_copyable<PackedVariant<P4, P6>>::value, "");
+}
+
+TEST(variant, packed_index_access) {
+    using ::state_machine::variant::PackedVariant;
+    using packed::P4;
+    using packed::P6;
+
+    PackedVariant<P4, P6> v{};
+    EXPECT_TRUE(v.holds<empty>());
+
+    auto& p6 = v.emplace<P6>();
+    EXPECT_TRUE(v.holds<P6>());
+
+    // Writes to the alternative do not change the index.
+    p6 = P6{{0xFFFF, 0xFFFF, 0xFFFF}};
+    EXPECT_TRUE(v.holds<P6>());
+    EXPECT_EQ(v.get<P6>().values[2], 0xFFFF);
+
+    v.set(P4{42});
+    EXPECT_TRUE(v.holds<P4>());
+
+    auto v2 = std::move(v);
+    EXPECT_TRUE(v2.holds<P4>());
+    EXPECT_EQ(v2.visit([](const auto& a) { return sizeof(a); }), sizeof(P4));
+    EXPECT_EQ(v2.get<P4>().value, 42U);
+}
+
+class VariantBoxedTest : public ::testing::Test {
+  protected:
+    static int dtor_count;
+
+    struct large {
+        explicit large(int x) : value{x} {}
+        large(large&&) = delete;
+        large(const large&) = delete;
+        auto operator=(large&&) -> large& = delete;
+        auto operator=(const large&) -> large& = delete;
+        ~large() { dtor_count++; }
+
+        int value;
+        // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+        char buffer[4096]{};
+    };
+
+    struct small {
+        int value;
+    };
+
+    void SetUp() override { dtor_count = 0; }
+};
+
+int VariantBoxedTest::dtor_count;
+
+TEST_F(VariantBoxedTest, size) {
+    using ::state_machine::variant::boxed;
+
+    static_assert(sizeof(Variant<boxed<large>, small>) <= 2 * sizeof(void*), "");
+    static_assert(!std::is_trivially_copyable<Variant<boxed<small>>>::value, "");
+}
+
+TEST_F(VariantBoxedTest, access) {
+    using ::state_machine::variant::boxed;
+
+    static constexpr int expected = 3;
+
+    {
+        Variant<boxed<large>, small> v{};
+
+        v.emplace<large>(expected);
+        EXPECT_TRUE(v.holds<large>());
+        EXPECT_EQ(v.get<large>().value, expected);
+        EXPECT_EQ(v.get_if<small>(), nullptr);
+        EXPECT_EQ(v.visit([](const auto& a) { return a.value; }), expected);
+
+        v.set(small{1});
+        EXPECT_EQ(dtor_count, 1);
+        EXPECT_TRUE(v.holds<small>());
+
+        v.emplace<large>(expected);
+    }
+    EXPECT_EQ(dtor_count, 2);
+}
+
+TEST_F(VariantBoxedTest, move_transfers_slot) {
+    using ::state_machine::variant::boxed;
+
+    static constexpr int expected = 4;
+
+    Variant<boxed<large>, small> v1{};
+    auto* address = std::addressof(v1.emplace<large>(expected));
+
+    auto v2 = std::move(v1);
+
+    // NOLINTNEXTLINE(bugprone-use-after-move,clang-analyzer-cplusplus.Move)
+    EXPECT_TRUE(v1.holds<empty>());
+    EXPECT_EQ(std::addressof(v2.get<large>()), address);
+    EXPECT_EQ(dtor_count, 0);
+
+    Variant<boxed<large>, small> v3{};
+    v3.set(small{1});
+    v3 = std::move(v2);
+
+    EXPECT_EQ(std::addressof(v3.get<large>()), address);
+    EXPECT_EQ(dtor_count, 0);
+}
+
+TEST_F(VariantBoxedTest, slot_is_recycled) {
+    using ::state_machine::variant::boxed;
+
+    Variant<boxed<large>, small> v{};
+    auto* address = std::addressof(v.emplace<large>(1));
+
+    v.set(small{1});
+    EXPECT_EQ(std::addressof(v.emplace<large>(2)), address);
+}